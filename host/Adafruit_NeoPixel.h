@@ -0,0 +1,98 @@
+// Host stand-in for Adafruit_NeoPixel. Pixel storage, color order and brightness
+// scaling follow the real library so render cost on the host is comparable;
+// show() only counts frames instead of clocking bits out of a pin.
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+typedef uint16_t neoPixelType;
+
+class Adafruit_NeoPixel {
+  public:
+    Adafruit_NeoPixel(uint16_t n, int16_t p = 6, neoPixelType t = NEO_GRB + NEO_KHZ800)
+      : pin(p) {
+      rOffset = (t >> 4) & 0b11;
+      gOffset = (t >> 2) & 0b11;
+      bOffset = t & 0b11;
+      updateLength(n);
+    }
+    ~Adafruit_NeoPixel() { free(pixels); }
+
+    void begin() { begun = true; }
+    void show()  { shows++; }
+
+    void updateLength(uint16_t n) {
+      free(pixels);
+      numBytes = n * 3;
+      pixels = (uint8_t *)calloc(numBytes, 1);
+      numLEDs = pixels ? n : 0;
+      if(!pixels) numBytes = 0;
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+      if(n < numLEDs) {
+        if(brightness) {
+          r = (r * brightness) >> 8;
+          g = (g * brightness) >> 8;
+          b = (b * brightness) >> 8;
+        }
+        uint8_t *p = &pixels[n * 3];
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+      }
+    }
+    void setPixelColor(uint16_t n, uint32_t c) {
+      setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+    }
+
+    uint32_t getPixelColor(uint16_t n) const {
+      if(n >= numLEDs) return 0;
+      const uint8_t *p = &pixels[n * 3];
+      if(brightness) {
+        return (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
+               (((uint32_t)(p[gOffset] << 8) / brightness) << 8) |
+               ((uint32_t)(p[bOffset] << 8) / brightness);
+      }
+      return ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+    }
+
+    // Stored as brightness + 1 so that 0 means "full, don't scale", same as the library
+    void setBrightness(uint8_t b) { brightness = b + 1; }
+    uint8_t getBrightness() const { return brightness - 1; }
+
+    void clear() { memset(pixels, 0, numBytes); }
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0) {
+      uint16_t end = (!count || first + count > numLEDs) ? numLEDs : first + count;
+      for(uint16_t i = first; i < end; i++) setPixelColor(i, c);
+    }
+
+    uint8_t *getPixels() const { return pixels; }
+    uint16_t numPixels() const { return numLEDs; }
+    int16_t  getPin() const { return pin; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+      return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    unsigned long shows = 0;   // host only: number of show() calls
+
+  private:
+    bool     begun = false;
+    uint16_t numLEDs = 0;
+    uint16_t numBytes = 0;
+    int16_t  pin;
+    uint8_t  brightness = 0;
+    uint8_t *pixels = nullptr;
+    uint8_t  rOffset, gOffset, bOffset;
+};
+
+#endif
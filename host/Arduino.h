@@ -0,0 +1,56 @@
+// Host stand-in for the Arduino core, used by [env:native] so main.cpp can run on Linux.
+// Only the parts of the API that main.cpp touches are provided.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+#define A0 14
+
+// Flash and RAM are the same thing on the host. Words are read bytewise, as on the AVR: program operands
+// (bytecode.h) sit at odd addresses.
+#define PROGMEM
+#define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)  hostReadWord(addr)
+#define pgm_read_dword(addr) hostReadDword(addr)
+#define memcpy_P memcpy
+
+inline uint16_t hostReadWord(const void *addr) {
+  uint16_t w;
+  memcpy(&w, addr, sizeof(w));
+  return w;
+}
+
+inline uint32_t hostReadDword(const void *addr) {
+  uint32_t d;
+  memcpy(&d, addr, sizeof(d));
+  return d;
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void pinMode(uint8_t pin, uint8_t mode);
+int  digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Host controls (not part of the Arduino API)
+void hostSetMillis(unsigned long ms);  // set the fake millis() clock
+void hostSetMicros(unsigned long us);  // set it in microseconds (for timing pulses)
+void hostSetPin(uint8_t pin, int level);  // drive an input pin
+
+#endif
@@ -0,0 +1,27 @@
+// Host stand-in for the Arduino EEPROM library (ATtiny85 sized, 512 bytes, erased to 0).
+// Tests can set 'size' to try the other boards' EEPROM (1024 bytes on the Nano and Beetle).
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdint.h>
+
+#ifndef E2END
+  #define E2END 0x1FF
+#endif
+#define EEPROM_HOST_MAX 1024      // largest EEPROM of the supported boards
+
+class EEPROMClass {
+  public:
+    uint8_t  read(int address)                { return data[address]; }
+    void     write(int address, uint8_t value) { data[address] = value; writes++; }
+    void     update(int address, uint8_t value) { if(data[address] != value) write(address, value); }
+    uint16_t length()                          { return size; }
+
+    uint8_t       data[EEPROM_HOST_MAX] = {0};
+    uint16_t      size = E2END + 1;        // host only: bytes in use, up to EEPROM_HOST_MAX
+    unsigned long writes = 0;              // host only: count of cell writes
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
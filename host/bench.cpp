@@ -0,0 +1,55 @@
+// Frame-render benchmark for [env:native].
+// Renders every pattern case for a fixed number of frames and reports the host cost per frame.
+// LED_COUNT is a build flag, so run host/bench.sh to sweep several strip lengths.
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "streamout.h"
+#include "parallelout.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_FRAMES 20000   // frames rendered per pattern (after warmup)
+#define BENCH_WARMUP 500     // frames rendered before timing starts
+
+// From src/main.cpp
+extern Adafruit_NeoPixel strip;
+extern uint8_t           pattern;
+extern unsigned long     pixelInterval;
+extern unsigned long     currentMillis;
+extern const uint16_t    pixelNumber;
+extern const uint8_t     totalPatterns;
+void setup();
+void renderPattern();
+
+int main(int argc, char **argv) {
+  unsigned long frames = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_FRAMES;
+  unsigned long now = 0;
+
+  setup();
+
+  printf("# LED_COUNT %u, %lu frames per pattern (show() not timed)\n", pixelNumber, frames);
+  printf("%-8s %10s %12s %14s %12s\n", "pattern", "leds", "ns/frame", "pixels/s", "shows/frame");
+  for(uint8_t p = 1; p <= totalPatterns; p++) {
+    pattern = p;
+    for(unsigned long f = 0; f < BENCH_WARMUP; f++) {
+      hostSetMillis(now);
+      currentMillis = now;
+      renderPattern();
+      now += pixelInterval;
+    }
+    unsigned long shows = strip.shows + streamFrames + parallelFrames;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long f = 0; f < frames; f++) {
+      hostSetMillis(now);
+      currentMillis = now;
+      renderPattern();
+      now += pixelInterval;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / frames;
+    printf("%-8u %10u %12.1f %14.0f %12.2f\n", p, pixelNumber, ns, pixelNumber * 1e9 / ns,
+           (double)(strip.shows + streamFrames + parallelFrames - shows) / frames);
+  }
+  return 0;
+}
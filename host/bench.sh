@@ -0,0 +1,11 @@
+#!/bin/sh
+# Run the native frame-render benchmark at several strip lengths.
+# Usage: host/bench.sh [led counts...]   (default: 30 74 150 300)
+set -e
+cd "$(dirname "$0")/.."
+COUNTS=${*:-"30 74 150 300"}
+for n in $COUNTS; do
+  PLATFORMIO_BUILD_FLAGS="-DLED_COUNT=$n" pio run -s -e native
+  .pio/build/native/program
+  echo
+done
@@ -0,0 +1,103 @@
+// Flight controller emulator for testing the MSP client (msp.h) on Linux: opens a pseudo-terminal and answers
+// MSP_STATUS, MSP_RC and MSP_ANALOG requests on it like Betaflight would, with a made up flight:
+// the throttle sweeps 1000-2000us every 4 s, the quad arms for 10 s in every 20, and a 4S pack drains from
+// 16.8 V by 0.1 V/s (under 14.0 V, the default MSPLOWCELL warning, after 28 s) and starts over at 40 s.
+// Run host/msp.sh, or by hand:
+//   g++ -std=gnu++17 -I include host/fcemu.cpp -o fcemu && ./fcemu    (prints the pty to set MSP_PORT to)
+// (not part of [env:native], it has its own main())
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "msp.h"
+
+static int fc;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void put16(uint8_t *p, unsigned v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void reply(uint8_t cmd, const uint8_t *payload, uint8_t size) {
+  uint8_t frame[64] = {'$', 'M', '>', size, cmd};
+  uint8_t sum = size ^ cmd;
+  for(uint8_t i = 0; i < size; i++) {
+    frame[5 + i] = payload[i];
+    sum ^= payload[i];
+  }
+  frame[5 + size] = sum;
+  if(write(fc, frame, 6 + size) < 0) {
+    perror("write");
+  }
+}
+
+static void answer(uint8_t cmd, double t) {
+  uint8_t p[32] = {0};
+  bool armed = (long)(t / 10) % 2 == 1;
+  double sweep = t / 4 - (long)(t / 4);
+  unsigned throttle = armed ? 1000 + (sweep < 0.5 ? sweep : 1 - sweep) * 2000 : 1000;
+  unsigned voltage = 1680 - (long)(t * 10) % 400;   // 1/100 V, drops 0.1 V a second, new pack every 40 s
+  switch(cmd) {
+    case MSP_STATUS:
+      put16(p, 125);                // cycle time
+      put16(p + 6, armed ? 1 : 0);  // flight mode flags: ARM
+      reply(cmd, p, 11);
+      break;
+    case MSP_RC:
+      for(int ch = 0; ch < 8; ch++) {
+        put16(p + ch * 2, ch == MSP_THROTTLE ? throttle : 1500);
+      }
+      reply(cmd, p, 16);
+      break;
+    case MSP_ANALOG:
+      p[0] = voltage / 10;
+      put16(p + 7, voltage);
+      reply(cmd, p, 9);
+      break;
+    default:
+      reply(cmd, p, 0);
+      break;
+  }
+  printf("\r%6.1fs  %s  throttle %4u  battery %5.2f V ", t, armed ? "armed   " : "disarmed", throttle, voltage / 100.0);
+  fflush(stdout);
+}
+
+int main() {
+  fc = posix_openpt(O_RDWR | O_NOCTTY);
+  if(fc < 0 || grantpt(fc) || unlockpt(fc)) {
+    perror("posix_openpt");
+    return 1;
+  }
+  struct termios tio;
+  tcgetattr(fc, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fc, TCSANOW, &tio);
+  printf("FC on %s\n", ptsname(fc));
+  fflush(stdout);
+
+  double start = seconds();
+  uint8_t request[6];
+  int have = 0;
+  for(;;) {
+    uint8_t c;
+    if(read(fc, &c, 1) != 1) {
+      usleep(1000);                 // nobody has the pty open yet
+      continue;
+    }
+    if(have == 0 && c != '$') continue;
+    request[have++] = c;
+    if(have < 6) continue;
+    have = 0;
+    if(request[1] == 'M' && request[2] == '<' && request[3] == 0 && request[5] == request[4]) {
+      answer(request[4], seconds() - start);
+    }
+  }
+}
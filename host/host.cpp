@@ -0,0 +1,35 @@
+// Host implementations of the Arduino calls used by main.cpp.
+// Time only moves when the host program calls hostSetMillis() or hostSetMicros(), so runs are repeatable.
+#include <Arduino.h>
+#include <EEPROM.h>
+
+EEPROMClass EEPROM;
+
+static unsigned long hostMicros = 0;
+static int           hostPins[32];
+static bool          hostPinsInit = false;
+
+static void hostInitPins() {
+  if(hostPinsInit) return;
+  for(int i = 0; i < 32; i++) hostPins[i] = HIGH;   // released buttons / pinio high
+  hostPinsInit = true;
+}
+
+unsigned long millis()               { return hostMicros / 1000UL; }
+unsigned long micros()               { return hostMicros; }
+void delay(unsigned long ms)         { hostMicros += ms * 1000UL; }
+void pinMode(uint8_t, uint8_t)       { hostInitPins(); }
+void digitalWrite(uint8_t, uint8_t)  {}
+
+int digitalRead(uint8_t pin) {
+  hostInitPins();
+  return pin < 32 ? hostPins[pin] : HIGH;
+}
+
+void hostSetMillis(unsigned long ms) { hostMicros = ms * 1000UL; }
+void hostSetMicros(unsigned long us) { hostMicros = us; }
+
+void hostSetPin(uint8_t pin, int level) {
+  hostInitPins();
+  if(pin < 32) hostPins[pin] = level;
+}
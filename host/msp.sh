@@ -0,0 +1,15 @@
+#!/bin/sh
+# Test the MSP client on Linux: start the FC emulator on a pseudo-terminal, then run the USEMSP firmware
+# against it in real time, with the throttle brightness on.
+# Usage: host/msp.sh [seconds] [pattern]   (default: 60 s, the saved pattern)
+set -e
+cd "$(dirname "$0")/.."
+mkdir -p .pio/msp
+FLAGS="-std=gnu++17 -O2 -I host -I include -DUSEMSP -DMSPTHROTTLEBRIGHT"
+g++ $FLAGS host/fcemu.cpp -o .pio/msp/fcemu
+g++ $FLAGS src/*.cpp host/host.cpp host/msplive.cpp -o .pio/msp/msplive
+.pio/msp/fcemu > .pio/msp/fcemu.log &
+FC=$!
+trap 'kill $FC' EXIT
+sleep 1
+MSP_PORT=$(sed -n 's/^FC on //p' .pio/msp/fcemu.log) .pio/msp/msplive "$@"
@@ -0,0 +1,45 @@
+// Runs the USEMSP firmware on Linux in real time against the MSP port in $MSP_PORT (see host/fcemu.cpp),
+// printing what the strip does with the telemetry twice a second. Run host/msp.sh.
+// (not part of [env:native], it has its own main())
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "msp.h"
+
+// From src/main.cpp
+extern Adafruit_NeoPixel strip;
+extern uint8_t           pattern;
+extern uint8_t           levelBrightness;
+extern bool              mspLowBattery;
+void setup();
+void loop();
+
+static unsigned long realMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+int main(int argc, char **argv) {
+  unsigned long seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : 60;
+  unsigned long start = realMillis(), printed = 0;
+  setup();
+  pattern = argc > 2 ? atoi(argv[2]) : pattern;
+  for(unsigned long now = 0; now < seconds * 1000; now = realMillis() - start) {
+    hostSetMillis(now);
+    loop();
+    if(now - printed >= 500) {
+      printed = now;
+      const uint8_t *px = strip.getPixels();
+      printf("%6.1fs  %s  %-8s  throttle %3u  battery %5.2f V  %-11s  brightness %3u  first led %3u %3u %3u\n",
+             now / 1000.0, mspFresh(now) ? "fresh" : "stale", telemetry.armed ? "armed" : "disarmed", telemetry.throttle,
+             telemetry.voltage / 100.0, mspLowBattery ? "LOW BATTERY" : "", levelBrightness, px[0], px[1], px[2]);
+      fflush(stdout);
+    }
+    usleep(1000);
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+// Pattern assembler: turns text pattern programs into the bytecode arrays run by program<C>() (see bytecode.h).
+// Build and run it on the PC, then rebuild the firmware:
+//   g++ -std=gnu++17 -I include host/patasm.cpp -o patasm && ./patasm include/programs.pat > include/programs.h
+// (not part of [env:native], it has its own main())
+//
+// Input, one instruction per line, '#' starts a comment:
+//   program <name>           start a program, <name> is the array to give the pattern table
+//   color <slot> <r> <g> <b>
+//   swap <slot> <slot>
+//   fill <slot> <pixels>     0 pixels: the rest of the strip
+//   part <slot> <256ths>
+//   wipe <slot>
+//   bands <width> <slot>...
+//   stripes <width> <slot>...
+//   wheel <stride>
+//   rainbow
+//   sparse <gap>
+//   end                      ends the program
+// Numbers are decimal, or hex with 0x.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+
+#define PATASM_SLOTS_MAX 8   // slots a bands/stripes op can take (PALETTE_MAX in main.cpp)
+
+struct Mnemonic {
+  const char *name;
+  uint8_t     op;
+  const char *symbol;
+};
+
+static const Mnemonic mnemonics[] = {
+  {"end",     OP_END,     "OP_END"},
+  {"color",   OP_COLOR,   "OP_COLOR"},
+  {"swap",    OP_SWAP,    "OP_SWAP"},
+  {"fill",    OP_FILL,    "OP_FILL"},
+  {"part",    OP_PART,    "OP_PART"},
+  {"wipe",    OP_WIPE,    "OP_WIPE"},
+  {"bands",   OP_BANDS,   "OP_BANDS"},
+  {"stripes", OP_STRIPES, "OP_STRIPES"},
+  {"wheel",   OP_WHEEL,   "OP_WHEEL"},
+  {"rainbow", OP_RAINBOW, "OP_RAINBOW"},
+  {"sparse",  OP_SPARSE,  "OP_SPARSE"},
+};
+
+static const char *source;
+static int         lineNumber;
+
+static void fail(const char *message, const char *what) {
+  fprintf(stderr, "%s:%d: %s%s%s\n", source, lineNumber, message, what ? ": " : "", what ? what : "");
+  exit(1);
+}
+
+static long number(const char *text, long low, long high) {
+  char *end;
+  long value = strtol(text, &end, 0);
+  if(*end || end == text) fail("not a number", text);
+  if(value < low || value > high) fail("out of range", text);
+  return value;
+}
+
+int main(int argc, char **argv) {
+  if(argc != 2) {
+    fprintf(stderr, "usage: %s programs.pat > programs.h\n", argv[0]);
+    return 2;
+  }
+  source = argv[1];
+  FILE *in = fopen(source, "r");
+  if(!in) {
+    perror(source);
+    return 1;
+  }
+
+  std::string out, name;
+  std::vector<std::string> code;   // items of the program being assembled
+  int draws = 0;                   // and its draw instructions (at most PROGRAM_DRAWS)
+  char line[256];
+  for(lineNumber = 1; fgets(line, sizeof(line), in); lineNumber++) {
+    char *comment = strchr(line, '#');
+    if(comment) *comment = 0;
+    std::vector<const char *> words;
+    for(char *w = strtok(line, " \t\r\n"); w; w = strtok(NULL, " \t\r\n")) {
+      words.push_back(w);
+    }
+    if(words.empty()) continue;
+
+    if(!strcmp(words[0], "program")) {
+      if(!name.empty()) fail("program has no end", name.c_str());
+      if(words.size() != 2) fail("program needs a name", NULL);
+      name = words[1];
+      code.clear();
+      draws = 0;
+      continue;
+    }
+    if(name.empty()) fail("instruction outside a program", words[0]);
+
+    const Mnemonic *m = NULL;
+    for(const Mnemonic &candidate : mnemonics) {
+      if(!strcmp(words[0], candidate.name)) m = &candidate;
+    }
+    if(!m) fail("unknown instruction", words[0]);
+    code.push_back(m->symbol);
+    if(m->op >= OP_FILL && ++draws > PROGRAM_DRAWS) fail("more than 8 draw instructions in a program", words[0]);
+
+    size_t args = words.size() - 1;
+    static const uint8_t argCount[OP_COUNT] = OP_ARGS;
+    bool list = m->op == OP_BANDS || m->op == OP_STRIPES;
+    size_t expected = m->op == OP_COLOR ? 4 : m->op == OP_FILL ? 2 : list ? args : argCount[m->op];
+    if(args != expected) fail("wrong number of arguments", words[0]);
+    switch(m->op) {
+      case OP_FILL: {
+        long pixels = number(words[2], 0, 65535);
+        code.push_back(std::to_string(number(words[1], 0, PROGRAM_SLOTS - 1)));
+        code.push_back(std::to_string(pixels & 255));
+        code.push_back(std::to_string(pixels >> 8));
+        break;
+      }
+      case OP_BANDS:
+      case OP_STRIPES:
+        if(args < 2 || args - 1 > PATASM_SLOTS_MAX) fail("needs a width and 1 to 8 slots", words[0]);
+        code.push_back(std::to_string(number(words[1], 1, 255)));
+        code.push_back(std::to_string(args - 1));
+        for(size_t i = 2; i < words.size(); i++) {
+          code.push_back(std::to_string(number(words[i], 0, PROGRAM_SLOTS - 1)));
+        }
+        break;
+      case OP_COLOR:
+      case OP_SWAP:
+      case OP_PART:
+      case OP_WIPE:
+        for(size_t i = 1; i < words.size(); i++) {   // the first argument is a slot, the others bytes
+          code.push_back(std::to_string(i == 1 || m->op == OP_SWAP ? number(words[i], 0, PROGRAM_SLOTS - 1)
+                                                                   : number(words[i], 0, 255)));
+        }
+        break;
+      case OP_SPARSE:
+        code.push_back(std::to_string(number(words[1], 1, 255)));
+        break;
+      default:
+        for(size_t i = 1; i < words.size(); i++) {
+          code.push_back(std::to_string(number(words[i], 0, 255)));
+        }
+        break;
+    }
+
+    if(m->op == OP_END) {
+      out += "const uint8_t " + name + "[] PROGMEM = {";
+      for(size_t i = 0; i < code.size(); i++) {
+        out += (i ? ", " : "") + code[i];
+      }
+      out += "};\n";
+      name.clear();
+    }
+  }
+  fclose(in);
+  if(!name.empty()) fail("program has no end", name.c_str());
+
+  printf("// Pattern programs, generated by host/patasm.cpp from %s. Edit that file, not this one.\n", source);
+  printf("#ifndef PROGRAMS_H\n#define PROGRAMS_H\n\n#include \"bytecode.h\"\n\n%s\n#endif\n", out.c_str());
+  return 0;
+}
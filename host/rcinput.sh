@@ -0,0 +1,8 @@
+#!/bin/sh
+# Test RCINPUT on Linux: run the firmware against a simulated 50 Hz servo pulse on the mode pin (host/rcsweep.cpp),
+# selecting patterns (or brightness levels: host/rcinput.sh RC_BRIGHTNESS).
+set -e
+cd "$(dirname "$0")/.."
+mkdir -p .pio/rcinput
+g++ -std=gnu++17 -O2 -I host -I include -DRCINPUT=${1:-RC_PATTERN} src/*.cpp host/host.cpp host/rcsweep.cpp -o .pio/rcinput/rcsweep
+.pio/rcinput/rcsweep
@@ -0,0 +1,87 @@
+// Runs the RCINPUT firmware on Linux against a simulated receiver: a 50 Hz servo pulse on the mode pin, with a
+// few microseconds of jitter, from a stick that is moved to the middle of every band in turn, parked on a band
+// edge, and then swept quickly from end to end. Prints how long each selection took to show, and the EEPROM
+// cells written (only selections held for RCSETTLEDELAY should be saved). Run host/rcinput.sh.
+// (not part of [env:native], it has its own main())
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stdio.h>
+
+#define RC_PERIOD 20000UL    // microseconds between pulses (50 Hz, analog servo rate)
+#define RC_JITTER 4          // +- microseconds of noise on each pulse
+#define RC_STEP   500UL      // microseconds between loop() calls (and one on each edge, so pulses are timed exactly)
+#define RC_HOLD   3000UL     // millis the stick is held at each position
+
+// From src/main.cpp
+extern uint8_t        pattern;
+extern uint8_t        levelBrightness;
+extern const uint8_t  rcBands;
+extern const uint16_t rcLow, rcHigh;
+extern const uint8_t  rcPin;
+void setup();
+void loop();
+
+static unsigned long now = 0;  // microseconds
+static uint16_t      noise = 1;
+
+// Hold the stick at 'width' for 'ms', sending pulses and running loop(). Returns the millis until the
+// selection (pattern or brightness) first changed, or -1 if it didn't.
+static long hold(uint16_t width, unsigned long ms) {
+  uint8_t selection = pattern, level = levelBrightness;
+  unsigned long start = now;
+  long changed = -1;
+  uint16_t pulse = width;
+  while(now - start < ms * 1000) {
+    unsigned long phase = now % RC_PERIOD;
+    if(phase == 0) {                           //  next pulse
+      noise = noise * 25173 + 13849;
+      pulse = width + (int)(noise >> 8) % (2 * RC_JITTER + 1) - RC_JITTER;
+    }
+    hostSetPin(rcPin, phase < pulse ? HIGH : LOW);
+    hostSetMicros(now);
+    loop();
+    if(changed < 0 && (pattern != selection || levelBrightness != level)) {
+      changed = (now - start) / 1000;
+    }
+    unsigned long next = now - phase + (phase < pulse ? pulse : RC_PERIOD);
+    now = now + RC_STEP < next ? now + RC_STEP : next;
+  }
+  return changed;
+}
+
+static void report(const char *what, uint16_t width, long changed, unsigned long writes) {
+  printf("%-6s %5u us   pattern %2u   brightness %3u   ", what, width, pattern, levelBrightness);
+  if(changed < 0) {
+    printf("%-16s", "no change");
+  } else {
+    printf("shown in %3ld ms ", changed);
+  }
+  printf("  eeprom cells written %lu\n", EEPROM.writes - writes);
+}
+
+int main() {
+  setup();
+  hold(rcLow - 100, RC_HOLD);                  //  receiver on, stick at the bottom
+
+  printf("# %u bands from %u to %u us, pulses every %lu us +-%u us\n", rcBands, rcLow, rcHigh, RC_PERIOD, RC_JITTER);
+  unsigned long step = (rcHigh - rcLow + 1) / rcBands;
+  for(uint8_t band = 0; band < rcBands; band++) {
+    uint16_t width = rcLow + band * step + step / 2;
+    unsigned long writes = EEPROM.writes;
+    report("band", width, hold(width, RC_HOLD), writes);
+  }
+
+  uint16_t edge = rcLow + (rcBands / 2) * step;     //  parked on a band edge: must not flicker between two
+  hold(edge - step / 2, RC_HOLD);
+  unsigned long writes = EEPROM.writes;
+  report("edge", edge, hold(edge, RC_HOLD), writes);
+
+  writes = EEPROM.writes;                         //  quick sweep: only the end position is saved
+  for(uint16_t width = rcLow; width < rcHigh; width += 20) {
+    hold(width, 20);
+  }
+  hold(rcHigh, RC_HOLD);
+  printf("sweep  %u-%u us in %u ms, held at the end: pattern %2u   brightness %3u   eeprom cells written %lu\n",
+         rcLow, rcHigh, (rcHigh - rcLow) / 20 * 20, pattern, levelBrightness, EEPROM.writes - writes);
+  return 0;
+}
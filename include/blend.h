@@ -0,0 +1,93 @@
+// Transition kernels: mix two frame buffers (TRANSITION in main.cpp).
+// Where there is a hardware multiplier, channels are blended four at a time in one 32-bit word (SWAR): the even
+// and odd bytes are spread into 16-bit lanes, so one multiply by the 7-bit mix amount scales two channels at once
+// without carries between them. That is two multiplies per 4 channels instead of four. Without one (the ATtiny85)
+// a 32-bit multiply is a __mulsi3 call, no cheaper than the byte multiplies it replaces, so each channel is
+// blended on its own there (BLEND_SWAR 0).
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef BLEND_SWAR
+  #if defined(__AVR__) && !defined(__AVR_HAVE_MUL__)
+    #define BLEND_SWAR 0
+  #else
+    #define BLEND_SWAR 1
+  #endif
+#endif
+
+// Transition types
+#define TRANSITION_FADE     0   // crossfade every pixel from the old frame to the new one
+#define TRANSITION_WIPE     1   // the new frame sweeps along the strip from the first pixel
+#define TRANSITION_DISSOLVE 2   // pixels switch to the new frame one at a time, in a scattered order
+
+#define BLEND_MAX 128           // mix amount that gives the new frame only (0 gives the old frame)
+
+// Mix two lanes of channel bytes (bits 0-7 and 16-23): from + (to - from) * mix / 128, rounded down.
+// to + 256 - from is 1-511 per lane and times mix (0-128) stays under 65536, so the lanes never carry
+// into each other. The + 256 comes back out as mix * 2 after the shift.
+inline uint32_t blendLanes(uint32_t from, uint32_t to, uint8_t mix) {
+  uint32_t diff = (to | 0x01000100UL) - from;
+  uint32_t step = ((diff * mix) >> 7) & 0x01FF01FFUL;
+  uint32_t bias = (uint16_t)(mix << 1);
+  return from + step - (bias | bias << 16);
+}
+
+// One channel byte, the same mix as blendLanes(): 8x8 bit multiplies only
+inline uint8_t blend1(uint8_t from, uint8_t to, uint8_t mix) {
+  if(to >= from) {
+    return from + (((uint16_t)(uint8_t)(to - from) * mix) >> 7);
+  }
+  return from - (((uint16_t)(uint8_t)(from - to) * mix + 127) >> 7);   // rounded down, as the lanes are
+}
+
+// Four channel bytes (one 32-bit word) mixed at once
+inline uint32_t blend4(uint32_t from, uint32_t to, uint8_t mix) {
+  uint32_t even = blendLanes(from & 0x00FF00FFUL, to & 0x00FF00FFUL, mix);
+  uint32_t odd  = blendLanes((from >> 8) & 0x00FF00FFUL, (to >> 8) & 0x00FF00FFUL, mix);
+  return even | (odd << 8);
+}
+
+// Mix 'bytes' channel bytes of 'from' into 'to' (in place), by mix / 128
+inline void blendBuffer(uint8_t *to, const uint8_t *from, uint16_t bytes, uint8_t mix) {
+#if BLEND_SWAR
+  while(bytes >= 4) {
+    uint32_t a, b;
+    memcpy(&a, from, 4);
+    memcpy(&b, to, 4);
+    b = blend4(a, b, mix);
+    memcpy(to, &b, 4);
+    from += 4;
+    to += 4;
+    bytes -= 4;
+  }
+#endif
+  while(bytes--) {
+    *to = blend1(*from++, *to, mix);
+    to++;
+  }
+}
+
+// Put back the old frame from pixel 'first' on: the new frame has only wiped up to there
+inline void wipeBuffer(uint8_t *to, const uint8_t *from, uint16_t first, uint16_t pixels) {
+  if(first < pixels) {
+    memcpy(to + first * 3, from + first * 3, (pixels - first) * 3);
+  }
+}
+
+// Put back the old frame on the pixels that have not dissolved yet. Each pixel has a fixed place in a
+// scattered order (an odd multiple of its index, mod 256) and switches once mix * 2 passes it.
+inline void dissolveBuffer(uint8_t *to, const uint8_t *from, uint16_t pixels, uint8_t mix) {
+  uint16_t threshold = mix * 2;
+  uint8_t rank = 0;
+  for(uint16_t i = 0; i < pixels; i++) {
+    if(rank >= threshold) {
+      memcpy(to + i * 3, from + i * 3, 3);
+    }
+    rank += 167;
+  }
+}
+
+#endif
@@ -0,0 +1,36 @@
+// Pattern bytecode: a pattern written as a short program instead of a renderer function, run by program<C>()
+// in main.cpp. A program is a byte array in PROGMEM, assembled from text by host/patasm.cpp (see
+// include/programs.pat). It runs once per frame and draws the strip from the first pixel to the last:
+// each draw op writes its pixels after the previous op's, and an op's pixel count of 0 means "the rest of the
+// strip". Animation comes from the pattern's steps (Pattern::speed), like the hand written renderers.
+//
+// Colors are drawn from a palette of PROGRAM_SLOTS slots, set by COLOR. Slot 0 starts as off (black).
+// Each frame the interpreter first works out every draw op's pixel count and phase (the multiplies and divides),
+// then draws with the same loops as the renderers. So the extra cost is per op, not per pixel, and nothing but
+// the draw loops runs between two pixels, which STREAMOUTPUT needs (see streamout.h).
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+
+#define PROGRAM_SLOTS 8
+#define PROGRAM_DRAWS 8   // draw ops (OP_FILL to OP_SPARSE) a program may have: their per frame numbers are worked out before the frame
+
+// Opcodes, followed by their argument bytes
+#define OP_END      0   //                        fill the rest of the strip with slot 0 and show the frame
+#define OP_COLOR    1   // slot r g b             set a palette slot
+#define OP_SWAP     2   // slot slot              swap two slots on odd steps (flashes, alternating halves)
+#define OP_FILL     3   // slot lo hi             'lo + 256 * hi' pixels of one slot
+#define OP_PART     4   // slot part              'part' 256ths of the strip of one slot
+#define OP_WIPE     5   // slot                   wipe the slot over the rest, then wipe slot 0 over it, a pixel per step
+#define OP_BANDS    6   // width n slot...        repeat n slots, each 'width' pixels wide, moving a pixel per step
+#define OP_STRIPES  7   // width n slot...        same, standing still
+#define OP_WHEEL    8   // stride                 Wheel() colors, 'stride' hues apart, a hue per step
+#define OP_RAINBOW  9   //                        the whole Wheel() spread over the strip, a hue per step
+#define OP_SPARSE   10  // gap                    every 'gap'th pixel in Wheel() colors, the rest slot 0, moving a pixel per step
+#define OP_COUNT    11
+
+// Argument bytes after each opcode (OP_BANDS and OP_STRIPES add one per slot)
+#define OP_ARGS {0, 4, 2, 3, 2, 1, 2, 2, 1, 0, 1}
+
+#endif
@@ -0,0 +1,39 @@
+// Board and strip configuration as types. The pattern renderers are templates on a StripConfig, so the strip
+// length, pins and color order are compile-time constants in their loops (see the USER CONFIGURATION in main.cpp).
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#ifdef __AVR__
+  #include <avr/io.h>
+#endif
+
+// SRAM of the target in bytes, for compile time RAM budget checks (no limit on the host)
+#if defined(RAMEND) && defined(RAMSTART)
+  constexpr uint16_t ramSize = RAMEND - RAMSTART + 1;
+#else
+  constexpr uint16_t ramSize = 0xFFFF;
+#endif
+
+// Pins of one board
+template <uint8_t LED, uint8_t MODE, uint8_t TOGGLE>
+struct BoardPins {
+  static constexpr uint8_t ledPin = LED;        // LED signal
+  static constexpr uint8_t modePin = MODE;      // mode button/fc signal
+  static constexpr uint8_t togglePin = TOGGLE;  // on/off button/fc signal
+};
+
+// A strip of LEDS leds of NeoPixel TYPE (color order + speed), driven from BOARD's LED pin.
+// Patterns draw COUNT of them, the rest are copies (see topology.h).
+template <class BOARD, uint16_t LEDS, uint16_t TYPE, uint16_t COUNT = LEDS>
+struct StripConfig {
+  typedef BOARD board;
+  static constexpr uint16_t leds = LEDS;    // leds on the strip (the frame buffer)
+  static constexpr uint16_t count = COUNT;  // leds the patterns draw
+  static constexpr uint16_t type = TYPE;
+  static constexpr uint16_t bufferBytes = LEDS * 3;  // frame buffer the NeoPixel library allocates
+  static constexpr uint32_t showMicros = LEDS * 30UL;  // 24 bits at 800KHz per led, with interrupts off
+  static_assert(COUNT <= LEDS, "patterns can't draw more leds than the strip has");
+};
+
+#endif
@@ -0,0 +1,30 @@
+// Compile time gamma table for the brightness pipeline (see levelBuild() in main.cpp).
+// Leds are linear in PWM duty, eyes are not, so channel values go through a power curve before output.
+// The table keeps 16 bits per entry, so scaling it down for a low brightness still leaves distinct steps.
+#ifndef GAMMA_H
+#define GAMMA_H
+
+#include <stdint.h>
+
+#define GAMMA_EXPONENT 2.5   // x^2.5, worked out as x * x * sqrt(x)
+
+struct GammaTable {
+  uint16_t level[256];   // 0-65535 duty for each 0-255 channel value
+
+  static constexpr double root(double x) {   // Newton's method, constexpr std::sqrt stand-in
+    double r = x > 1 ? x : 1;
+    for(int i = 0; i < 32; i++) {
+      r = (r + x / r) / 2;
+    }
+    return r;
+  }
+
+  constexpr GammaTable() : level() {
+    for(int i = 0; i < 256; i++) {
+      double x = i / 255.0;
+      level[i] = (uint16_t)(x * x * root(x) * 65535 + 0.5);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,52 @@
+// Debounced inputs with press / hold / release events.
+// Pin changes are caught by the pin change interrupt where the pin has one (all pins on the ATtiny85,
+// port B pins on the Nano and Beetle), which timestamps every edge even while loop() is busy.
+// Other pins (e.g. A0 on the Beetle) are polled on every inputUpdate() instead.
+// Inputs are active low: a button to ground, or betaflight pinio driving the pin low.
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+#define INPUT_MAX 2
+
+enum InputEvent : uint8_t {
+  INPUT_NONE,
+  INPUT_PRESS,     // pin went low and stayed low for the debounce time
+  INPUT_HOLD,      // still low, sent every 'repeat' millis after the press (if repeat is not 0)
+  INPUT_RELEASE,   // pin went high and stayed high for the debounce time
+};
+
+// Set up an input. pullup: use the internal pullup (buttons), or not (push/pull pinio).
+// repeat: millis between INPUT_HOLD events while held, 0 for none. Returns the input's index.
+uint8_t inputBegin(uint8_t pin, bool pullup, uint16_t repeat);
+
+// Run the input's debounce state machine and return what happened since the last call
+InputEvent inputUpdate(uint8_t input, unsigned long now);
+
+// Debounced state of the input (true = low)
+bool inputPressed(uint8_t input);
+
+// RC pulse input: the width of servo pulses (or a PWM duty) on one pin, for selecting a pattern or brightness with
+// a transmitter switch or knob (RCINPUT in main.cpp). Edges are timed with clockMicros() in the pin change interrupt,
+// so the pin needs one. show() turns interrupts off, so an edge during it is only seen when it ends, too late to
+// time: mark show() with pulseBlackout(), and a pulse with an edge inside one is dropped. (clockMicros() makes up
+// for the ticks micros() loses in a show, so a pulse around one is fine.) Pulses outside PULSE_MIN-PULSE_MAX are
+// dropped too.
+#define PULSE_MIN 800      // microseconds
+#define PULSE_MAX 2200
+
+#define RC_PATTERN    1    // RCINPUT modes: the pulse width picks the pattern,
+#define RC_BRIGHTNESS 2    // or the brightness level
+
+// Set up the pulse input (one only). Returns false if the pin has no pin change interrupt (then pulses are
+// timed by polling in pulseRead(), which is only as precise as loop() is fast).
+bool pulseBegin(uint8_t pin);
+
+// The width of the latest good pulse, in microseconds. Returns false if there was none since the last call.
+bool pulseRead(uint16_t &width);
+
+// Interrupts are going off (true), or are back on and clockBlackout() has been called (false)
+void pulseBlackout(bool dark);
+
+#endif
@@ -0,0 +1,47 @@
+// Frame timing instrumentation, for measuring a build on the real board (no simulator or debugger needed).
+// Times the sections below with clockMicros(), keeps the last INSTRUMENT_RING frames and a log2 histogram
+// per section, and dumps them as text every few seconds: over Serial on boards with a UART or USB
+// (Beetle, Nano), or bit-banged 8N1 on a spare pin on the Digispark (read it with any USB-serial adapter
+// or a logic analyzer). Build with INSTRUMENT defined in main.cpp (or -DINSTRUMENT) to enable it.
+// Without INSTRUMENT the markers compile to nothing and the module is dropped by the linker.
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+
+// Timed sections
+#define INSTR_RENDER   0   // renderPattern(), including any show() it makes
+#define INSTR_SHOW     1   // sending the frame to the strip
+#define INSTR_INPUT    2   // reading the pins and acting on them (incl. any EEPROM save)
+#define INSTR_SECTIONS 3
+
+#define INSTRUMENT_RING    8   // frames kept for the dump
+#define INSTRUMENT_BUCKETS 8   // histogram buckets: <64us, <128us, ... <4096us, and everything longer
+#define INSTRUMENT_BAUD    57600
+
+// Start output on 'pin' (Digispark only, the other boards use Serial), dumping every 'dumpMillis'
+void instrumentBegin(uint8_t pin, unsigned long dumpMillis);
+
+// Mark the start and end of a section. A section can run more than once per frame (the longest counts).
+void instrumentStart(uint8_t section);
+void instrumentStop(uint8_t section);
+
+// Close the frame rendered by 'pattern': record its section times and any frames dropped (frameSkips)
+void instrumentFrame(uint8_t pattern);
+
+// Dump the ring and histograms when one is due. Call between frames, the dump blocks while it is sent.
+void instrumentPoll(unsigned long now);
+
+#ifdef INSTRUMENT
+  #define INSTR_START(id)       instrumentStart(id)
+  #define INSTR_STOP(id)        instrumentStop(id)
+  #define INSTR_FRAME(pattern)  instrumentFrame(pattern)
+  #define INSTR_POLL(now)       instrumentPoll(now)
+#else
+  #define INSTR_START(id)       ((void)0)
+  #define INSTR_STOP(id)        ((void)0)
+  #define INSTR_FRAME(pattern)  ((void)0)
+  #define INSTR_POLL(now)       ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,46 @@
+// MSP (MultiWii Serial Protocol v1) telemetry client: polls the flight controller for arming state, flight
+// modes, throttle and battery voltage over a UART, so patterns can react to them (see USEMSP in main.cpp).
+// Betaflight side: enable MSP on the UART wired to the board (Ports tab), at MSP_BAUD.
+// Requests go out one at a time, every MSP_POLLMS, and replies are parsed a byte at a time as they arrive,
+// so mspPoll() never waits for the FC: it costs a few microseconds per call, a frame is never held up.
+// UART: Serial1 on the Beetle (pins 0/1, USB stays free), Serial on the Nano (shared with USB).
+// On the host the port is the file named by the MSP_PORT environment variable (e.g. the pty of host/fcemu.cpp).
+#ifndef MSP_H
+#define MSP_H
+
+#include <stdint.h>
+
+#define MSP_BAUD         115200
+#define MSP_POLLMS       25    // millis between requests (throttle every other request, status and battery every fourth)
+#define MSP_TIMEOUT      500   // millis without a reply before the telemetry is stale
+#define MSP_THROTTLE     3     // throttle channel in MSP_RC, 0-based (AETR channel order)
+#define MSP_PAYLOAD_MAX  12    // reply bytes kept, enough for the fields used below
+
+// MSP v1 commands used
+#define MSP_STATUS  101
+#define MSP_RC      105
+#define MSP_ANALOG  110
+
+struct MspTelemetry {
+  bool          armed;       // ARM box active (bit 0 of the flight mode flags)
+  uint32_t      modes;       // flight mode flags of MSP_STATUS, one bit per active box in the FC's box order
+  uint8_t       throttle;    // throttle stick, 0 (1000us or less) to 255 (2000us or more)
+  uint16_t      voltage;     // battery voltage in 1/100 V, 0 if the FC has no voltage sensor
+  unsigned long millis;      // millis of the last good reply
+};
+
+extern MspTelemetry telemetry;
+
+// Open the UART
+void mspBegin();
+
+// Send the next request when due, and parse whatever bytes have arrived. Call once per loop().
+void mspPoll(unsigned long now);
+
+// True if the FC has answered within MSP_TIMEOUT (the telemetry is current)
+bool mspFresh(unsigned long now);
+
+// Build a request frame for 'cmd' (no payload) into 'frame', returns its length (6)
+uint8_t mspRequest(uint8_t cmd, uint8_t *frame);
+
+#endif
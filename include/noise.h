@@ -0,0 +1,76 @@
+// 8-bit fixed point noise and random numbers for the procedural effects (fire, plasma, twinkle, sparkle).
+// No floats, no divides, and only 8x8 multiplies (scale8). The ATtiny85 has no hardware multiply, so each
+// scale8 is a libgcc shift-and-add loop: the hash is multiply free, and the 8x8 ones are only in the blends
+// (1D noise: 3, 2D noise: 7).
+// Noise is value noise: a hashed random value at every whole coordinate, blended between them with a
+// smoothstep curve, so it is smooth like Perlin noise but cheaper. Coordinates are 8.8 fixed point:
+// the high byte picks the lattice cell, the low byte is the position inside it.
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+// a * b / 256, for scaling a value by a fraction
+inline uint8_t scale8(uint8_t a, uint8_t b) {
+  return ((uint16_t)a * b) >> 8;
+}
+
+// Linear blend from a (t = 0) to b (t = 256)
+inline uint8_t lerp8(uint8_t a, uint8_t b, uint8_t t) {
+  return b >= a ? a + scale8(b - a, t) : a - scale8(a - b, t);
+}
+
+// Smoothstep 3t^2 - 2t^3 = t^2 + 2t^2(1 - t), so noise has no visible kinks at the lattice points
+inline uint8_t ease8(uint8_t t) {
+  uint8_t t2 = scale8(t, t);
+  uint16_t s = t2 + 2 * scale8(t2, 255 - t);
+  return s > 255 ? 255 : s;
+}
+
+inline uint8_t rotl8(uint8_t v, uint8_t n) {
+  return v << n | v >> (8 - n);
+}
+
+// Random looking byte for a lattice point (same input, same output). Add-rotate-xor rounds on the two bytes,
+// 8-bit register operations only.
+inline uint8_t hash8(uint16_t x) {
+  uint8_t a = x ^ 0xA7, b = x >> 8;
+  b += rotl8(a, 4);
+  a = (a + rotl8(b, 1)) ^ 0x5C;
+  b ^= rotl8(a, 4);
+  a += b + 0x3B;
+  b += rotl8(a, 1);
+  a ^= rotl8(b, 4);
+  return a + rotl8(b, 2);
+}
+
+// 1D value noise, 0-255. x is 8.8 fixed point: one lattice cell per 256.
+inline uint8_t noise8(uint16_t x) {
+  uint8_t cell = x >> 8;
+  return lerp8(hash8(cell), hash8(cell + 1), ease8(x));
+}
+
+// 2D value noise, 0-255 (e.g. position along the strip and time). The lattice point hashed is the x cell in
+// the low byte and the y cell in the high one, so the lattice repeats every 256 cells each way.
+inline uint8_t noise8(uint16_t x, uint16_t y) {
+  uint8_t  cx = x >> 8, cy = y >> 8;
+  uint8_t  tx = ease8(x), ty = ease8(y);
+  uint8_t  top = lerp8(hash8(cx | cy << 8), hash8((uint8_t)(cx + 1) | cy << 8), tx);
+  cy++;
+  uint8_t  bottom = lerp8(hash8(cx | cy << 8), hash8((uint8_t)(cx + 1) | cy << 8), tx);
+  return lerp8(top, bottom, ty);
+}
+
+// Xorshift PRNG (Marsaglia, 7/9/8 shifts): period 65535, a few cycles per number. The state must not be 0.
+inline uint16_t xorshift16(uint16_t &state) {
+  state ^= state << 7;
+  state ^= state >> 9;
+  state ^= state << 8;
+  return state;
+}
+
+inline uint8_t random8(uint16_t &state) {
+  return xorshift16(state) >> 8;
+}
+
+#endif
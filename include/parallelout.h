@@ -0,0 +1,45 @@
+// Bit-parallel WS2812 output: up to PARALLEL_MAX strips on pins of one port are clocked out together,
+// so a frame takes as long as the longest strip instead of the sum of all of them (PARALLELOUTPUT in main.cpp).
+// The frame buffer holds the strips one after the other (strip 0's pixels, then strip 1's, ...), in wire order,
+// which is how the patterns already see one long strip.
+// Each bit is 22 cycles (1.33us at 16.5MHz): all strips high, the ones sending a 0 low after 6 cycles, the rest
+// after 13. The next bit's port value is worked out in the gaps. Between bytes the lines idle low for a few us
+// while the next bytes are loaded, well under the WS2812 latch time.
+#ifndef PARALLELOUT_H
+#define PARALLELOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PARALLEL_MAX 4   // strips driven at once
+
+struct ParallelStrip {
+  uint8_t  pin;     // Arduino pin of the strip's data line
+  uint16_t count;   // leds on the strip
+};
+
+// Leds on all strips together (must match the strip length the patterns render)
+template <size_t N>
+constexpr uint16_t parallelTotal(const ParallelStrip (&strips)[N]) {
+  uint16_t total = 0;
+  for(size_t i = 0; i < N; i++) {
+    total += strips[i].count;
+  }
+  return total;
+}
+
+// Set up the strips' pins as outputs. Strips past PARALLEL_MAX, or on a different port than the first, are left out.
+void parallelBegin(const ParallelStrip *strips, uint8_t count);
+
+// Send one frame to all strips. Interrupts are off while it runs (see parallelShowMicros()).
+void parallelShow(const uint8_t *pixels);
+
+// How long parallelShow() keeps interrupts off, for clockBlackout()
+uint32_t parallelShowMicros();
+
+#ifndef __AVR__
+// Host only: frames sent
+extern unsigned long parallelFrames;
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+// Pattern table entry. Each pattern in main.cpp's patterns[] table is a renderer plus its settings.
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdint.h>
+
+struct Pattern;
+struct PatternState;
+typedef void (*PatternRenderer)(const Pattern &p, PatternState &s);
+
+struct Pattern {
+  PatternRenderer render;    // draws one frame and shows it
+  uint32_t        color[3];  // colors used by the renderer (unused ones are ignored)
+  uint8_t         width;     // band/cluster width for patterns that have one
+  uint32_t        speed;     // animation steps per millisecond, 16.16 fixed point (see perSecond())
+  uint16_t        interval;  // millis between frames, only sets smoothness (speed comes from 'speed')
+  const uint8_t  *program;   // bytecode for the program renderer (see bytecode.h), other renderers leave it out
+};
+
+// State the current pattern keeps between frames. There is one of these for all patterns, cleared whenever the
+// pattern changes, so a new pattern always starts from its first step. Renderers derive their phase from 'steps';
+// one that needs more state adds its own struct here, in a union with the others.
+struct PatternState {
+  uint32_t      steps;     // animation steps since the pattern started
+  uint16_t      fraction;  // fraction of the next step, 1/65536ths
+  union {                  // (next to 'fraction', so it packs into the padding before 'millis' on 64 bit hosts)
+    struct {
+      uint16_t    seed;      // xorshift16() state (0 until the first frame seeds it)
+    } sparkle;
+  };
+  unsigned long millis;    // millis the animation was last advanced to
+};
+#define PATTERNSTATE_MAX 16  // SRAM budget for PatternState (bytes), checked at compile time
+static_assert(sizeof(PatternState) <= PATTERNSTATE_MAX, "PatternState is over its SRAM budget");
+
+// Same packing as Adafruit_NeoPixel::Color(), but usable in constant tables
+constexpr uint32_t rgb(uint8_t r, uint8_t g, uint8_t b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+// Animation speed in steps per second, as the fixed point steps per millisecond stored in Pattern::speed.
+// A step is one hue for the rainbows, one pixel for chases and wipes, one on/off swap for flashes.
+constexpr uint32_t perSecond(uint16_t steps) {
+  return ((uint32_t)steps * 65536 + 500) / 1000;
+}
+
+#endif
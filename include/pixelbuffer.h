@@ -0,0 +1,85 @@
+// Fill/copy kernels that write straight into the Adafruit_NeoPixel pixel buffer (strip.getPixels()).
+// Colors are converted to wire order (color order + brightness applied) once with wireColor(),
+// then the kernels only move bytes, with no per pixel bounds check, unpacking or scaling.
+// Callers keep every pixel index below numPixels().
+#ifndef PIXELBUFFER_H
+#define PIXELBUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// One pixel as it is stored in the buffer and sent down the wire
+struct WirePixel {
+  uint8_t b[3];
+};
+
+// Byte offset of each channel for a NEO_xxx color order (same decoding as the library)
+constexpr uint8_t wireOffsetR(uint16_t type) { return (type >> 4) & 0b11; }
+constexpr uint8_t wireOffsetG(uint16_t type) { return (type >> 2) & 0b11; }
+constexpr uint8_t wireOffsetB(uint16_t type) { return type & 0b11; }
+
+// Packed rgb color to wire order, with the same brightness scaling setPixelColor() applies
+template <uint16_t TYPE>
+inline WirePixel wireColor(uint32_t color, uint8_t brightness) {
+  uint8_t r = color >> 16, g = color >> 8, b = color;
+  uint8_t scale = brightness + 1;   // 255 wraps to 0 = full brightness, as in the library
+  if(scale) {
+    r = (r * scale) >> 8;
+    g = (g * scale) >> 8;
+    b = (b * scale) >> 8;
+  }
+  WirePixel px = {};
+  px.b[wireOffsetR(TYPE)] = r;
+  px.b[wireOffsetG(TYPE)] = g;
+  px.b[wireOffsetB(TYPE)] = b;
+  return px;
+}
+
+// Packed rgb color to wire order, scaled through a 256 entry brightness table
+template <uint16_t TYPE>
+inline WirePixel wireColorTable(uint32_t color, const uint8_t *scale) {
+  WirePixel px = {};
+  px.b[wireOffsetR(TYPE)] = scale[(uint8_t)(color >> 16)];
+  px.b[wireOffsetG(TYPE)] = scale[(uint8_t)(color >> 8)];
+  px.b[wireOffsetB(TYPE)] = scale[(uint8_t)color];
+  return px;
+}
+
+// Set 'count' pixels starting at 'first' to one color
+inline void fillSolid(uint8_t *buf, uint16_t first, uint16_t count, WirePixel px) {
+  uint8_t *p = buf + first * 3;
+  while(count--) {
+    *p++ = px.b[0];
+    *p++ = px.b[1];
+    *p++ = px.b[2];
+  }
+}
+
+// Copy 'count' pixels from 'src' to 'dst' (ranges may overlap)
+inline void copyRange(uint8_t *buf, uint16_t dst, uint16_t src, uint16_t count) {
+  memmove(buf + dst * 3, buf + src * 3, count * 3);
+}
+
+// Copy 'count' pixels from 'src' to 'dst' in reverse order, so the first source pixel lands on the last
+// destination pixel (ranges must not overlap)
+inline void copyReversed(uint8_t *buf, uint16_t dst, uint16_t src, uint16_t count) {
+  const uint8_t *s = buf + src * 3;
+  uint8_t *d = buf + (dst + count) * 3;
+  while(count--) {
+    d -= 3;
+    d[0] = s[0];
+    d[1] = s[1];
+    d[2] = s[2];
+    s += 3;
+  }
+}
+
+// Scale every byte by 'scale'/256 (e.g. to dim a frame that is already drawn)
+inline void scaleBuffer(uint8_t *buf, uint16_t bytes, uint8_t scale) {
+  while(bytes--) {
+    *buf = (*buf * scale) >> 8;
+    buf++;
+  }
+}
+
+#endif
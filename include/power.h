@@ -0,0 +1,48 @@
+// Strip current estimate and limiter (POWERBUDGET in main.cpp).
+// A WS2812 channel draws about LED_MA_CHANNEL at full level, in proportion to its level (the PWM duty),
+// and each LED draws LED_MA_IDLE even when dark. So the frame's current is a constant plus the sum of
+// every channel level sent: the "load", added up run by run as the frame is written (no pass over the buffer).
+// A frame whose load is over budget is scaled down to it just before show(). STREAMOUTPUT frames are out
+// before their load is known, so the frames after one are dimmed instead (through the level table).
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "pixelbuffer.h"
+
+#define LED_MA_CHANNEL 20   // mA of one channel at level 255
+#define LED_MA_IDLE    1    // mA of one LED with all channels at 0
+
+// Channel level sum allowed for 'leds' LEDs within 'milliamps'
+constexpr uint32_t powerBudget(uint32_t milliamps, uint16_t leds) {
+  return (milliamps - (uint32_t)LED_MA_IDLE * leds) * 255 / LED_MA_CHANNEL;
+}
+
+// Estimated current (mA) of a frame with this load
+constexpr uint32_t powerMilliamps(uint32_t load, uint16_t leds) {
+  return (uint32_t)LED_MA_IDLE * leds + load * LED_MA_CHANNEL / 255;
+}
+
+// Load of one pixel
+inline uint16_t pixelLoad(const WirePixel &px) {
+  return px.b[0] + px.b[1] + px.b[2];
+}
+
+// Scale (of 256) that brings 'load' within 'budget' (call only when it is over)
+inline uint8_t powerScale(uint32_t load, uint32_t budget) {
+  return budget * 256 / load;
+}
+
+// Dim (brightness scale of 256, minus 1) that keeps even an all white frame of 'leds' LEDs within 'budget'
+constexpr uint8_t powerSafeDim(uint32_t budget, uint16_t leds) {
+  return budget * 256 / (765UL * leds) > 255 ? 255 : budget * 256 / (765UL * leds) ? budget * 256 / (765UL * leds) - 1 : 0;
+}
+
+// Dim for the next frames, from the 'load' a frame drew at 'dim': loads scale with the dim, so this is the one
+// that would have brought the frame to 'budget' (255 for no dimming)
+inline uint8_t powerNextDim(uint32_t load, uint32_t budget, uint8_t dim) {
+  uint32_t next = load ? budget * (dim + 1) / load : 256;
+  return next > 255 ? 255 : next ? next - 1 : 0;
+}
+
+#endif
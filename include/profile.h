@@ -0,0 +1,27 @@
+// Profiling markers for the simavr cycle harness (sim/profile.c).
+// Build with -DPROFILE (the digispark-tiny-profile env) and each marker becomes a single
+// write to GPIOR0, which the harness timestamps with the simulator's cycle counter.
+// Without PROFILE the markers compile to nothing.
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Section ids (bit 7 of the marker is set on exit)
+#define PROF_LOOP    1    // one pass through loop()
+#define PROF_RENDER  2    // renderPattern(), including any show() it makes
+#define PROF_WHEEL   3    // Wheel() color lookup
+#define PROF_SHOW    4    // strip.show() transmission
+#define PROF_BLEND   5    // mixing the old and new frame during a pattern transition
+#define PROF_POWER   6    // scaling a frame down to the POWERBUDGET current
+
+#define PROF_EXIT_FLAG 0x80
+
+#if defined(PROFILE) && defined(__AVR__)
+  #include <avr/io.h>
+  #define PROF_ENTER(id) (GPIOR0 = (id))
+  #define PROF_EXIT(id)  (GPIOR0 = (id) | PROF_EXIT_FLAG)
+#else
+  #define PROF_ENTER(id) ((void)0)
+  #define PROF_EXIT(id)  ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,12 @@
+// Pattern programs, generated by host/patasm.cpp from include/programs.pat. Edit that file, not this one.
+#ifndef PROGRAMS_H
+#define PROGRAMS_H
+
+#include "bytecode.h"
+
+const uint8_t navLights[] PROGMEM = {OP_COLOR, 1, 255, 0, 0, OP_COLOR, 2, 0, 255, 0, OP_COLOR, 3, 255, 255, 255, OP_COLOR, 4, 255, 255, 255, OP_SWAP, 1, 3, OP_SWAP, 2, 4, OP_PART, 1, 128, OP_FILL, 2, 0, 0, OP_END};
+const uint8_t rainbowFullProgram[] PROGMEM = {OP_RAINBOW, OP_END};
+const uint8_t tricolorChaseProgram[] PROGMEM = {OP_COLOR, 1, 255, 0, 0, OP_COLOR, 2, 255, 255, 255, OP_COLOR, 3, 0, 0, 255, OP_BANDS, 1, 3, 1, 2, 3, OP_END};
+const uint8_t rainbowChaseProgram[] PROGMEM = {OP_SPARSE, 3, OP_END};
+
+#endif
@@ -0,0 +1,31 @@
+// Frame timing: a millis() clock that makes up for ticks lost while show() has interrupts off,
+// and deadline based frame scheduling that neither drifts nor bursts to catch up.
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// millis(), plus the timer ticks that were lost while interrupts were off (see clockBlackout())
+unsigned long clockMillis();
+
+// micros(), plus the time that was lost while interrupts were off (for timing sections that include a show())
+unsigned long clockMicros();
+
+// Record that interrupts were off for 'us' microseconds (e.g. a strip transmission).
+// The timer interrupt can only catch up one missed overflow afterwards, the rest are added back here.
+void clockBlackout(uint32_t us);
+
+// True when the next frame is due
+bool frameDue(unsigned long now);
+
+// Call after a frame has been rendered. The next deadline is one 'interval' after the previous
+// deadline, not after 'now', so loop lateness does not add up. If a frame overran a whole
+// interval the missed frames are dropped (counted in frameSkips) and timing restarts from 'now'.
+void frameDone(unsigned long now, unsigned long interval);
+
+// Make the next frame due right away (e.g. a new pattern)
+void frameRestart(unsigned long now);
+
+extern uint16_t frameSkips;   // frames dropped because rendering overran (wraps)
+
+#endif
@@ -0,0 +1,58 @@
+// Saved settings: a wear leveling log of fixed size records in EEPROM.
+// Each save writes the next slot (wrapping at the end of EEPROM) with a sequence number one higher
+// than the last, so every slot is written once per EEPROM_SIZE / 8 saves. The newest record with a
+// good CRC wins at boot, so a save cut short by a power loss leaves the previous record in charge.
+// The record layout and CRC are plain C so the simavr harness can read and write them too.
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+
+#define SETTINGS_MAGIC 0xA5     // marks a slot as a settings record (and changes if the layout does)
+
+typedef struct {
+  uint8_t magic;                // SETTINGS_MAGIC
+  uint8_t seq;                  // sequence number, one higher than the previous save (wraps)
+  uint8_t pattern;              // locked pattern number
+  uint8_t brightness;           // led brightness, 0-255
+  uint8_t spare[3];             // room for more settings, written as 0
+  uint8_t crc;                  // CRC-8 of the bytes above
+} SettingsRecord;
+
+#define SETTINGS_RECORD_SIZE 8
+
+// CRC-8 (poly 0x07, init 0xFF) over the record, not counting the crc byte itself
+static inline uint8_t settingsCrc(const SettingsRecord *rec) {
+  const uint8_t *p = (const uint8_t *)rec;
+  uint8_t crc = 0xFF;
+  for(uint8_t i = 0; i < SETTINGS_RECORD_SIZE - 1; i++) {
+    crc ^= p[i];
+    for(uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static inline int settingsValid(const SettingsRecord *rec) {
+  return rec->magic == SETTINGS_MAGIC && rec->crc == settingsCrc(rec);
+}
+
+// True if record a was saved after record b. Sequence numbers wrap, which is fine as long as
+// there are fewer slots than half the sequence range (64 slots on a 512 byte EEPROM).
+static inline int settingsNewer(const SettingsRecord *a, const SettingsRecord *b) {
+  return (int8_t)(a->seq - b->seq) > 0;
+}
+
+#ifdef __cplusplus
+static_assert(sizeof(SettingsRecord) == SETTINGS_RECORD_SIZE, "settings record layout changed");
+
+// Load the newest saved settings into rec. Returns false (rec untouched) if EEPROM has none.
+// Reads each slot once, so boot time is bounded by the EEPROM size, not by how it was written.
+bool settingsLoad(SettingsRecord &rec);
+
+// Save rec as a new record in the next slot. Only bytes that differ from the slot are written.
+void settingsSave(SettingsRecord &rec);
+#endif
+
+#endif
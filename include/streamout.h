@@ -0,0 +1,22 @@
+// Bufferless WS2812 output. The pixels of a frame are sent one at a time as the pattern
+// produces them, so no LED_COUNT * 3 byte frame buffer is needed (STREAMOUTPUT in main.cpp).
+// Interrupts stay off from streamBegin() to streamEnd(). Between two streamPixel() calls the data
+// line idles low, and WS2812s latch after roughly 5us low. So the code that works out the next
+// pixel has about 80 cycles at 16.5MHz: table lookups and counters, no software multiplies or divides.
+#ifndef STREAMOUT_H
+#define STREAMOUT_H
+
+#include <stdint.h>
+#include "pixelbuffer.h"
+
+void streamBegin(uint8_t pin);            // wait out the latch time, disable interrupts
+void streamPixel(const WirePixel &px);    // clock out one pixel (3 bytes, wire order)
+void streamEnd();                         // restore interrupts
+
+#ifndef __AVR__
+// Host only: streamed pixels are copied here (if set), and frames are counted
+extern uint8_t      *streamCapture;
+extern unsigned long streamFrames;
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+// Strip topology: how the physical strip is laid out on the airframe (TOPOLOGY in main.cpp).
+// The strip is cut into segments (an arm, a bar...). A segment either is rendered, or copies another segment
+// of the same length, forwards or mirrored. Patterns only draw the rendered segments, one after the other as
+// if they were one shorter strip, and the copies are filled in after each frame.
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct Segment {
+  uint16_t first;     // first led of the segment on the physical strip
+  uint16_t count;     // leds in the segment
+  bool     reversed;  // pattern pixel 0 is at the far end (the segment is wired towards the hub)
+  uint8_t  source;    // segment this one copies, or its own index if it is rendered
+};
+
+// Leds the patterns draw: the rendered segments
+template <size_t N>
+constexpr uint16_t topologyRendered(const Segment (&map)[N]) {
+  uint16_t total = 0;
+  for(size_t i = 0; i < N; i++) {
+    if(map[i].source == i) total += map[i].count;
+  }
+  return total;
+}
+
+// True if the segments cover leds 0..count-1 in order with no gaps, and every copy is of a rendered segment of its length
+template <size_t N>
+constexpr bool topologyValid(const Segment (&map)[N], uint16_t count) {
+  uint16_t next = 0;
+  for(size_t i = 0; i < N; i++) {
+    const Segment &s = map[i];
+    if(s.first != next || !s.count || s.source >= N) return false;
+    if(map[s.source].source != s.source || map[s.source].count != s.count) return false;
+    next += s.count;
+  }
+  return next == count;
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Compile time color wheel and rainbow hue tables.
+// Both are built by constexpr constructors, so the compiler fills them in and they can live in PROGMEM.
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdint.h>
+
+// Same r - g - b - back to r transition as the original Wheel() math, one rgb triple per position.
+struct WheelTable {
+  uint8_t rgb[256][3];
+
+  constexpr WheelTable() : rgb() {
+    for(int i = 0; i < 256; i++) {
+      int pos = 255 - i;
+      if(pos < 85) {
+        rgb[i][0] = 255 - pos * 3;
+        rgb[i][1] = 0;
+        rgb[i][2] = pos * 3;
+      }
+      else if(pos < 170) {
+        pos -= 85;
+        rgb[i][0] = 0;
+        rgb[i][1] = pos * 3;
+        rgb[i][2] = 255 - pos * 3;
+      }
+      else {
+        pos -= 170;
+        rgb[i][0] = pos * 3;
+        rgb[i][1] = 255 - pos * 3;
+        rgb[i][2] = 0;
+      }
+    }
+  }
+};
+
+// Hue offset of each pixel when the whole wheel is spread over the strip (i * 256 / N)
+template <uint16_t N>
+struct RainbowTable {
+  uint8_t hue[N];
+
+  constexpr RainbowTable() : hue() {
+    for(uint16_t i = 0; i < N; i++) {
+      hue[i] = (uint32_t)i * 256 / N;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,9 @@
+#!/bin/sh
+# Build the crossfade PROFILE firmware and run the cycle harness with the strip toggled off and on every
+# 600ms, so every pattern keeps fading in and out. The blend columns are the transition cost.
+# Extra arguments go to the harness, e.g. sim/blend.sh -t 5
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-blend
+pio run -s -e simavr
+.pio/build/simavr/program -x 600 -l 40 "$@" .pio/build/digispark-tiny-blend/firmware.elf
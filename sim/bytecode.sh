@@ -0,0 +1,17 @@
+#!/bin/sh
+# Build the BYTECODETWINS PROFILE firmware and compare the render cycles of each bytecode program with the
+# hand written renderer it copies (patterns 19-21 draw the same frames as 2, 3 and 5, see main.cpp).
+# Extra arguments go to the harness, e.g. sim/bytecode.sh -t 5
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-bytecode
+pio run -s -e simavr
+.pio/build/simavr/program "$@" .pio/build/digispark-tiny-bytecode/firmware.elf | tee /dev/stderr | awk '
+  !/^#/ && $1 ~ /^[0-9]+$/ { render[$1] = $3 }
+  END {
+    split("2 19 3 20 5 21", pair, " ")
+    printf "\n%-10s %-10s %14s %14s %8s\n", "renderer", "program", "render/frame", "render/frame", "ratio"
+    for(i = 1; i < 6; i += 2) {
+      printf "%-10s %-10s %14s %14s %8.3f\n", pair[i], pair[i+1], render[pair[i]], render[pair[i+1]], render[pair[i+1]] / render[pair[i]]
+    }
+  }'
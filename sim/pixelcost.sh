@@ -0,0 +1,15 @@
+#!/bin/sh
+# Per LED render cost of every pattern on the ATtiny85, and the highest frame rate it could run at
+# (render + show back to back, 16.5 MHz). Patterns 15-18 are the noise effects (fire, plasma, twinkle, sparkle).
+# Usage: sim/pixelcost.sh [harness arguments]   LED_COUNT is the one in src/main.cpp, or set PLATFORMIO_BUILD_FLAGS=-DLED_COUNT=n
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-profile
+pio run -s -e simavr
+LEDS=$(echo "$PLATFORMIO_BUILD_FLAGS" | sed -n 's/.*-DLED_COUNT=\([0-9]*\).*/\1/p')
+LEDS=${LEDS:-$(sed -n 's/.*define LED_COUNT \([0-9]*\).*/\1/p' src/main.cpp | head -1)}
+.pio/build/simavr/program "$@" .pio/build/digispark-tiny-profile/firmware.elf | awk -v leds="$LEDS" '
+  BEGIN { printf "# %d leds\n%-8s %14s %10s %14s %10s\n", leds, "pattern", "render/frame", "render/px", "show/frame", "max fps" }
+  /^#/ || $1 !~ /^[0-9]+$/ { next }
+  { show = $6 ? $6 : leds * 30 * 16.5      # a frame the pattern did not resend still costs a show at full rate
+    printf "%-8s %14s %10.1f %14s %10.0f\n", $1, $3, $3 / leds, $6, 16500000 / ($3 + show) }'
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Profile every pattern with and without POWERBUDGET, and print what the current estimate and limiter cost:
+# the extra render cycles per pixel, and the cycles of the dimming pass on frames over the budget.
+# Extra arguments go to the harness, e.g. sim/power.sh -t 5
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-profile
+pio run -s -e digispark-tiny-power
+pio run -s -e simavr
+.pio/build/simavr/program "$@" .pio/build/digispark-tiny-profile/firmware.elf > .pio/power-off.txt
+.pio/build/simavr/program "$@" .pio/build/digispark-tiny-power/firmware.elf > .pio/power-on.txt
+LEDS=$(sed -n 's/.*LED_COUNT \([0-9]*\).*/\1/p' src/main.cpp | head -1)
+awk -v leds="$LEDS" '
+  /^#/ { next }
+  FNR == NR { if($1 ~ /^[0-9]+$/) off[$1] = $3; next }
+  $1 ~ /^[0-9]+$/ { printf "%-8s %14s %14s %12.1f %12s\n", $1, off[$1], $3, ($3 - off[$1]) / leds, $NF }
+  BEGIN { printf "%-8s %14s %14s %12s %12s\n", "pattern", "render/frame", "with budget", "extra/px", "limit/frame" }
+' .pio/power-off.txt .pio/power-on.txt
@@ -0,0 +1,228 @@
+// Cycle profiler for the firmware image, run under simavr.
+// Boots the PROFILE build once per pattern (a settings record for the pattern is preloaded into
+// EEPROM, so the real setup() path selects it), runs it for a fixed amount of simulated time and timestamps every
+// GPIOR0 marker written by include/profile.h. Prints one row per pattern; diff the output
+// between commits to catch loop budget regressions.
+// With -x, the toggle pin is switched off and on again every given millis, so a TRANSITION build keeps blending
+// into the pattern; -l is the strip length, for the blend cycles per pixel. limit/frame is the POWERBUDGET dimming pass.
+//
+// Usage: program [-m mcu] [-f hz] [-t seconds] [-p port] [-a modebit] [-b togglebit] [-x millis] [-l leds] firmware.elf
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_eeprom.h>
+#include <simavr/avr_ioport.h>
+
+#include "../include/profile.h"
+#include "../include/settings.h"
+
+#define MAX_SECTIONS 16
+#define MAX_DEPTH    8
+#define MAX_PATTERNS 64
+#define EEPROM_SIZE  4096
+
+typedef struct {
+  uint64_t count;
+  uint64_t total;
+  uint64_t worst;
+} section_t;
+
+typedef struct {
+  section_t sections[MAX_SECTIONS];
+  uint8_t   stackId[MAX_DEPTH];
+  uint64_t  stackStart[MAX_DEPTH];
+  int       depth;
+} prof_t;
+
+static const struct {
+  const char *mcu;
+  uint16_t    gpior0;   // data space address of GPIOR0
+} gpior0Table[] = {
+  { "attiny85",   0x31 },
+  { "atmega328p", 0x3E },
+  { "atmega32u4", 0x3E },
+};
+
+static void markerWrite(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  prof_t *p = (prof_t *)param;
+  uint8_t id = v & ~PROF_EXIT_FLAG;
+  (void)addr;
+  if(id >= MAX_SECTIONS) return;
+  if(!(v & PROF_EXIT_FLAG)) {
+    if(p->depth < MAX_DEPTH) {
+      p->stackId[p->depth] = id;
+      p->stackStart[p->depth] = avr->cycle;
+    }
+    p->depth++;
+    return;
+  }
+  // Unwind to the matching enter (tolerates a missed exit marker)
+  while(p->depth > 0) {
+    p->depth--;
+    if(p->depth < MAX_DEPTH && p->stackId[p->depth] == id) {
+      uint64_t dt = avr->cycle - p->stackStart[p->depth];
+      section_t *s = &p->sections[id];
+      s->count++;
+      s->total += dt;
+      if(dt > s->worst) s->worst = dt;
+      break;
+    }
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-t seconds] [-p port] [-a modebit] [-b togglebit] [-x millis] [-l leds] firmware.elf\n", name);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *mcu = "attiny85";
+  uint32_t    frequency = 16500000;
+  double      seconds = 2.0;
+  char        port = 'B';
+  int         modeBit = 1, toggleBit = 2;
+  double      toggleMs = 0;
+  int         leds = 74;
+  int         opt;
+
+  while((opt = getopt(argc, argv, "m:f:t:p:a:b:x:l:")) != -1) {
+    switch(opt) {
+      case 'm': mcu = optarg; break;
+      case 'f': frequency = strtoul(optarg, NULL, 10); break;
+      case 't': seconds = atof(optarg); break;
+      case 'p': port = optarg[0]; break;
+      case 'a': modeBit = atoi(optarg); break;
+      case 'b': toggleBit = atoi(optarg); break;
+      case 'x': toggleMs = atof(optarg); break;
+      case 'l': leds = atoi(optarg); break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind >= argc) usage(argv[0]);
+
+  uint16_t gpior0 = 0;
+  for(size_t i = 0; i < sizeof(gpior0Table) / sizeof(gpior0Table[0]); i++) {
+    if(!strcmp(gpior0Table[i].mcu, mcu)) gpior0 = gpior0Table[i].gpior0;
+  }
+  if(!gpior0) {
+    fprintf(stderr, "unknown mcu '%s'\n", mcu);
+    return 2;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if(elf_read_firmware(argv[optind], &firmware)) {
+    fprintf(stderr, "can't load %s\n", argv[optind]);
+    return 1;
+  }
+  strncpy(firmware.mmcu, mcu, sizeof(firmware.mmcu) - 1);
+  firmware.frequency = frequency;
+
+  printf("# %s @ %u Hz, %.1f s simulated per pattern, cycles include ~2 per marker\n", mcu, frequency, seconds);
+  printf("%-8s %7s %14s %12s %12s %14s %12s %10s %12s %9s %12s\n",
+         "pattern", "frames", "render/frame", "wheel/frame", "wheel/call", "show/frame", "loop worst", "worst us",
+         "blend/frame", "blend/px", "limit/frame");
+
+  uint64_t worstLoop = 0;
+  int      worstPattern = 0;
+  for(int pattern = 1; pattern < MAX_PATTERNS; pattern++) {
+    avr_t *avr = avr_make_mcu_by_name(mcu);
+    if(!avr) {
+      fprintf(stderr, "simavr has no core for '%s'\n", mcu);
+      return 1;
+    }
+    avr_init(avr);
+    avr->log = LOG_NONE;
+    avr_load_firmware(avr, &firmware);
+
+    static prof_t prof;
+    memset(&prof, 0, sizeof(prof));
+    avr_register_io_write(avr, gpior0, markerWrite, &prof);
+
+    // Preload a settings record for the pattern where setup() looks for it
+    uint8_t image[EEPROM_SIZE];
+    memset(image, 0xFF, sizeof(image));
+    SettingsRecord *rec = (SettingsRecord *)image;
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = SETTINGS_MAGIC;
+    rec->pattern = pattern;
+    rec->brightness = 255;
+    rec->crc = settingsCrc(rec);
+    avr_eeprom_desc_t ee = { .ee = image, .offset = 0, .size = avr->e2end + 1 };
+    if(ee.size > EEPROM_SIZE) ee.size = EEPROM_SIZE;
+    avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &ee);
+
+    // Strip on, mode locked (both inputs high)
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), modeBit), 1);
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), toggleBit), 1);
+
+    uint64_t end = (uint64_t)(seconds * frequency);
+    uint64_t toggleCycles = (uint64_t)(toggleMs * frequency / 1000), toggleNext = toggleCycles;
+    int toggleLevel = 1;
+    int state = cpu_Running;
+    while(avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+      state = avr_run(avr);
+      if(toggleCycles && avr->cycle >= toggleNext) {    // strip off, then back on into the pattern
+        toggleLevel = !toggleLevel;
+        avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), toggleBit), toggleLevel);
+        toggleNext += toggleCycles;
+      }
+    }
+
+    // setup() saves the default pattern over an out of range one, which marks the end of the list
+    avr_eeprom_desc_t check = { .ee = image, .offset = 0, .size = ee.size };
+    avr_ioctl(avr, AVR_IOCTL_EEPROM_GET, &check);
+    const SettingsRecord *slots = (const SettingsRecord *)image;
+    int latest = -1;
+    for(uint32_t i = 0; i < ee.size / SETTINGS_RECORD_SIZE; i++) {
+      if(settingsValid(&slots[i]) && (latest < 0 || settingsNewer(&slots[i], &slots[latest]))) {
+        latest = i;
+      }
+    }
+    int valid = latest >= 0 && slots[latest].pattern == pattern;
+    avr_terminate(avr);
+    if(!valid) {
+      if(pattern == 1) {              // the preload itself didn't take: a table now would be empty, not a result
+        fprintf(stderr, "setup() did not keep the preloaded pattern 1 (EEPROM layout, or the pins in -p/-a/-b?)\n");
+        return 1;
+      }
+      break;
+    }
+    if(!prof.sections[PROF_LOOP].count) {
+      fprintf(stderr, "no profiling markers seen: build the firmware with -DPROFILE (digispark-tiny-profile)\n");
+      return 1;
+    }
+
+    section_t *render = &prof.sections[PROF_RENDER];
+    section_t *wheel  = &prof.sections[PROF_WHEEL];
+    section_t *show   = &prof.sections[PROF_SHOW];
+    section_t *loop   = &prof.sections[PROF_LOOP];
+    section_t *blend  = &prof.sections[PROF_BLEND];
+    section_t *power  = &prof.sections[PROF_POWER];
+    uint64_t frames = render->count ? render->count : 1;
+    uint64_t blends = blend->count ? blend->count : 1;
+    printf("%-8d %7llu %14llu %12llu %12llu %14llu %12llu %10.1f %12llu %9.1f %12llu\n",
+           pattern,
+           (unsigned long long)render->count,
+           (unsigned long long)((render->total - show->total) / frames),
+           (unsigned long long)(wheel->count / frames),
+           (unsigned long long)(wheel->count ? wheel->total / wheel->count : 0),
+           (unsigned long long)(show->total / frames),
+           (unsigned long long)loop->worst,
+           loop->worst * 1e6 / frequency,
+           (unsigned long long)(blend->total / blends),
+           (double)blend->total / blends / leds,
+           (unsigned long long)(power->total / frames));
+    if(loop->worst > worstLoop) {
+      worstLoop = loop->worst;
+      worstPattern = pattern;
+    }
+  }
+  printf("# worst loop(): %llu cycles (%.1f us) in pattern %d\n",
+         (unsigned long long)worstLoop, worstLoop * 1e6 / frequency, worstPattern);
+  return 0;
+}
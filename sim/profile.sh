@@ -0,0 +1,8 @@
+#!/bin/sh
+# Build the PROFILE firmware and the simavr harness, then print the per-pattern cycle table.
+# Extra arguments go to the harness, e.g. sim/profile.sh -t 5
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-profile
+pio run -s -e simavr
+.pio/build/simavr/program "$@" .pio/build/digispark-tiny-profile/firmware.elf
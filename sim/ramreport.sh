@@ -0,0 +1,22 @@
+#!/bin/sh
+# Build each board env and report its flash use (.text + .data) and static SRAM use (.data + .bss), and the largest
+# RAM variables. pio run itself fails an env whose flash is over its board_upload.maximum_size.
+# What is left over is shared by the stack and the NeoPixel frame buffer (allocated at startup, LED_COUNT * 3 bytes).
+# Usage: sim/ramreport.sh [envs...]   (default: every atmelavr env in platformio.ini)
+set -e
+cd "$(dirname "$0")/.."
+TOOLS=${PLATFORMIO_CORE_DIR:-$HOME/.platformio}/packages/toolchain-atmelavr/bin
+ENVS=${*:-$(pio project config --json-output | python3 -c '
+import json, sys
+for name, opts in json.load(sys.stdin):
+    opts = dict(opts)
+    if name.startswith("env:") and opts.get("platform", "") == "atmelavr":
+        print(name[4:])')}
+for env in $ENVS; do
+  pio run -s -e "$env"
+  elf=.pio/build/$env/firmware.elf
+  echo "== $env"
+  "$TOOLS/avr-size" -C "$elf" | grep -E '^(Device|Program|Data)'
+  "$TOOLS/avr-nm" -C -S --size-sort -r -t d "$elf" | awk '$3 ~ /^[bBdD]$/' | head -8
+  echo
+done
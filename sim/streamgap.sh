@@ -0,0 +1,14 @@
+#!/bin/sh
+# Build the STREAMOUTPUT firmware and the simavr waveform checker, then run every pattern and check that the line
+# never sits low between two streamed pixels for longer than a WS2812 waits before it latches (about 5us).
+# Usage: sim/streamgap.sh [patterns...]   (default 1-15, the patterns of the digispark-tiny-stream build)
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-stream
+pio run -s -e simwave
+failed=0
+for n in ${*:-$(seq 1 15)}; do
+  out=$(.pio/build/simwave/program -t 2 -n "$n" -s 0 .pio/build/digispark-tiny-stream/firmware.elf) || failed=1
+  printf "pattern %-3s %s\n" "$n" "$(echo "$out" | tail -n +3)"
+done
+exit $failed
@@ -0,0 +1,215 @@
+// WS2812 waveform checker for the firmware image, run under simavr.
+// Boots the firmware (with a settings record for one pattern preloaded into EEPROM), watches the strip data pins
+// and decodes each one the way a WS2812 would: high pulses are classed as 0 or 1 bits by their width, and a long
+// low latches the frame. Prints the pulse timing seen on each pin, any pulse outside the WS2812 windows, and the
+// first pixels of the last frame, so an output driver (streamout, parallelout) can be checked without hardware.
+// Fails if a low inside a frame is longer than the gap limit: the datasheet latch is 50us, but real WS2812s latch
+// after about 5us, so a longer gap between two pixels splits the frame on a strip.
+//
+// Usage: program [-m mcu] [-f hz] [-t seconds] [-p port] [-a modebit] [-b togglebit] [-n pattern] [-g gap ns] -s bit[,bit...] firmware.elf
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/avr_eeprom.h>
+#include <simavr/avr_ioport.h>
+
+#include "../include/settings.h"
+
+#define MAX_PINS     8
+#define MAX_BYTES    4096
+#define EEPROM_SIZE  4096
+
+// WS2812B windows (ns): a 0 is high 250-550, a 1 is high 650-950, and a low over LATCH_NS latches
+#define T0H_MIN   250
+#define T0H_MAX   550
+#define T1H_MIN   650
+#define T1H_MAX   950
+#define LATCH_NS  50000
+#define GAP_NS    5000            // longest low allowed inside a frame (-g)
+
+typedef struct {
+  avr_t    *avr;
+  int       bit;
+  uint64_t  rise, fall;           // cycle of the last edges
+  int       level;
+  uint32_t  frameBits;            // bits in the frame being received
+  uint8_t   bytes[MAX_BYTES];     // the frame being received
+  uint8_t   last[MAX_BYTES];      // the last complete frame
+  uint32_t  lastBits;
+  uint32_t  frames;
+  uint32_t  bad;                  // high pulses outside both windows
+  uint32_t  oddFrames;            // frames that were not a whole number of leds
+  double    t0Min, t0Max, t1Min, t1Max, lowMax;   // ns
+} pin_t;
+
+static double nsPerCycle;
+
+static void frameEnd(pin_t *p) {
+  if(!p->frameBits) return;
+  p->frames++;
+  if(p->frameBits % 24) p->oddFrames++;
+  p->lastBits = p->frameBits;
+  memcpy(p->last, p->bytes, sizeof(p->last));
+  memset(p->bytes, 0, sizeof(p->bytes));
+  p->frameBits = 0;
+}
+
+static void pinChange(struct avr_irq_t *irq, uint32_t value, void *param) {
+  pin_t *p = (pin_t *)param;
+  uint64_t now = p->avr->cycle;
+  (void)irq;
+  if(!!value == p->level) return;
+  p->level = !!value;
+  if(p->level) {                                     // rising: the low before it either latched or sat between bits
+    double low = (now - p->fall) * nsPerCycle;
+    if(low > LATCH_NS) {
+      frameEnd(p);
+    }
+    else if(p->frameBits && low > p->lowMax) {
+      p->lowMax = low;
+    }
+    p->rise = now;
+    return;
+  }
+  double high = (now - p->rise) * nsPerCycle;        // falling: the high pulse is one bit
+  p->fall = now;
+  int one;
+  if(high >= T0H_MIN && high <= T0H_MAX) {
+    one = 0;
+    if(high < p->t0Min) p->t0Min = high;
+    if(high > p->t0Max) p->t0Max = high;
+  }
+  else if(high >= T1H_MIN && high <= T1H_MAX) {
+    one = 1;
+    if(high < p->t1Min) p->t1Min = high;
+    if(high > p->t1Max) p->t1Max = high;
+  }
+  else {
+    p->bad++;
+    one = high > (T0H_MAX + T1H_MIN) / 2;
+  }
+  if(p->frameBits < MAX_BYTES * 8 && one) {
+    p->bytes[p->frameBits / 8] |= 0x80 >> (p->frameBits % 8);
+  }
+  p->frameBits++;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-t seconds] [-p port] [-a modebit] [-b togglebit] [-n pattern] [-g gap ns] -s bit[,bit...] firmware.elf\n", name);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *mcu = "attiny85";
+  uint32_t    frequency = 16500000;
+  double      seconds = 1.0;
+  char        port = 'B';
+  int         modeBit = 1, toggleBit = 2;
+  int         pattern = 2;
+  double      gap = GAP_NS;
+  int         bits[MAX_PINS], pins = 0;
+  int         opt;
+
+  while((opt = getopt(argc, argv, "m:f:t:p:a:b:n:g:s:")) != -1) {
+    switch(opt) {
+      case 'm': mcu = optarg; break;
+      case 'f': frequency = strtoul(optarg, NULL, 10); break;
+      case 't': seconds = atof(optarg); break;
+      case 'p': port = optarg[0]; break;
+      case 'a': modeBit = atoi(optarg); break;
+      case 'b': toggleBit = atoi(optarg); break;
+      case 'n': pattern = atoi(optarg); break;
+      case 'g': gap = atof(optarg); break;
+      case 's':
+        for(char *s = strtok(optarg, ","); s && pins < MAX_PINS; s = strtok(NULL, ",")) {
+          bits[pins++] = atoi(s);
+        }
+        break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind >= argc || !pins) usage(argv[0]);
+  nsPerCycle = 1e9 / frequency;
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if(elf_read_firmware(argv[optind], &firmware)) {
+    fprintf(stderr, "can't load %s\n", argv[optind]);
+    return 1;
+  }
+  strncpy(firmware.mmcu, mcu, sizeof(firmware.mmcu) - 1);
+  firmware.frequency = frequency;
+
+  avr_t *avr = avr_make_mcu_by_name(mcu);
+  if(!avr) {
+    fprintf(stderr, "simavr has no core for '%s'\n", mcu);
+    return 1;
+  }
+  avr_init(avr);
+  avr->log = LOG_NONE;
+  avr_load_firmware(avr, &firmware);
+
+  // Preload a settings record for the pattern where setup() looks for it
+  uint8_t image[EEPROM_SIZE];
+  memset(image, 0xFF, sizeof(image));
+  SettingsRecord *rec = (SettingsRecord *)image;
+  memset(rec, 0, sizeof(*rec));
+  rec->magic = SETTINGS_MAGIC;
+  rec->pattern = pattern;
+  rec->brightness = 255;
+  rec->crc = settingsCrc(rec);
+  avr_eeprom_desc_t ee = { .ee = image, .offset = 0, .size = avr->e2end + 1 };
+  if(ee.size > EEPROM_SIZE) ee.size = EEPROM_SIZE;
+  avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &ee);
+
+  // Strip on, mode locked (both inputs high)
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), modeBit), 1);
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), toggleBit), 1);
+
+  static pin_t state[MAX_PINS];
+  for(int i = 0; i < pins; i++) {
+    pin_t *p = &state[i];
+    memset(p, 0, sizeof(*p));
+    p->avr = avr;
+    p->bit = bits[i];
+    p->t0Min = p->t1Min = 1e9;
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bits[i]), pinChange, p);
+  }
+
+  uint64_t end = (uint64_t)(seconds * frequency);
+  int run = cpu_Running;
+  while(avr->cycle < end && run != cpu_Done && run != cpu_Crashed) {
+    run = avr_run(avr);
+  }
+  for(int i = 0; i < pins; i++) {                    // the line has been low since the last bit
+    if((avr->cycle - state[i].fall) * nsPerCycle > LATCH_NS) frameEnd(&state[i]);
+  }
+
+  printf("# %s @ %u Hz, %.1f s simulated, pattern %d\n", mcu, frequency, seconds, pattern);
+  printf("%-4s %7s %6s %15s %15s %10s %5s %5s  %s\n",
+         "pin", "frames", "leds", "T0H ns", "T1H ns", "low max", "bad", "odd", "first pixels (wire order)");
+  int failed = 0;
+  for(int i = 0; i < pins; i++) {
+    pin_t *p = &state[i];
+    printf("%c%-3d %7u %6u %7.0f-%-7.0f %7.0f-%-7.0f %8.2fus %5u %5u ",
+           port, p->bit, p->frames, p->lastBits / 24,
+           p->t0Min < 1e9 ? p->t0Min : 0, p->t0Max, p->t1Min < 1e9 ? p->t1Min : 0, p->t1Max,
+           p->lowMax / 1000, p->bad, p->oddFrames);
+    for(uint32_t b = 0; b < 12 && b < p->lastBits / 8; b++) {
+      printf("%s%02x", b % 3 ? "" : " ", p->last[b]);
+    }
+    printf("\n");
+    if(!p->frames || p->bad || p->oddFrames) failed = 1;
+    if(p->lowMax > gap) {
+      printf("%c%d: a %.2fus low inside a frame, over the %.2fus a WS2812 may take as a latch\n",
+             port, p->bit, p->lowMax / 1000, gap / 1000);
+      failed = 1;
+    }
+  }
+  avr_terminate(avr);
+  return failed;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+# Build the PARALLELOUTPUT firmware and the simavr waveform checker, then decode what each strip pin sends.
+# Extra arguments go to the checker, e.g. sim/wave.sh -n 4 -t 2   (default pins: PB0 and PB4, see PARALLELSTRIPS)
+set -e
+cd "$(dirname "$0")/.."
+pio run -s -e digispark-tiny-parallel
+pio run -s -e simwave
+.pio/build/simwave/program -s 0,4 "$@" .pio/build/digispark-tiny-parallel/firmware.elf
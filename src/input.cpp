@@ -0,0 +1,202 @@
+// Debounced, edge captured inputs, see input.h
+#include <Arduino.h>
+#include "input.h"
+#include "scheduler.h"
+
+#define DEBOUNCEDELAY 20   // millis a new level has to hold before it counts
+
+struct Input {
+  uint8_t                pin;
+  volatile uint8_t      *port;         // input register and bit, for fast reads in the interrupt
+  uint8_t                mask;
+  bool                   interrupt;    // edges are captured by the pin change interrupt
+  volatile bool          raw;          // last level seen (true = low)
+  volatile unsigned long edgeMillis;   // when the level last changed
+  bool                   pressed;      // debounced level
+  uint16_t               repeat;
+  unsigned long          holdMillis;   // when the last press or hold event was sent
+};
+
+static Input   inputs[INPUT_MAX];
+static uint8_t inputCount = 0;
+
+static uint8_t                pulsePin;
+#ifdef __AVR__
+static volatile uint8_t      *pulsePort;
+static uint8_t                pulseMask;
+#endif
+static bool                   pulseInterrupt = false;  // pulse input is set up on the pin change interrupt
+static volatile bool          pulseHigh = false;       // level after the last edge
+static volatile bool          pulseDark = false;       // interrupts are off for show(), edge times are late
+static volatile bool          pulseTimed = false;      // the rising edge of the pulse in progress was timed
+static volatile unsigned long pulseRise;               // clockMicros of it
+static volatile uint16_t      pulseWidth;              // last good pulse
+static volatile bool          pulseNew = false;        // and it has not been read yet
+
+static inline bool inputRead(const Input &in) {
+#ifdef __AVR__
+  return !(*in.port & in.mask);
+#else
+  return digitalRead(in.pin) == LOW;
+#endif
+}
+
+static inline bool pulseLevel() {
+#ifdef __AVR__
+  return *pulsePort & pulseMask;
+#else
+  return digitalRead(pulsePin) == HIGH;
+#endif
+}
+
+// A pulse edge at 'now' (clockMicros). High starts a pulse, low ends it and keeps its width if it was timed right.
+static void pulseEdge(bool high, unsigned long now) {
+  pulseHigh = high;
+  if(high) {
+    pulseRise = now;
+    pulseTimed = !pulseDark;
+    return;
+  }
+  unsigned long width = now - pulseRise;
+  if(pulseTimed && !pulseDark && width >= PULSE_MIN && width <= PULSE_MAX) {
+    pulseWidth = width;
+    pulseNew = true;
+  }
+  pulseTimed = false;
+}
+
+#ifdef __AVR__
+// All supported boards put their pin change capable input pins on the PCINT0 vector
+ISR(PCINT0_vect) {
+  if(pulseInterrupt) {
+    bool high = pulseLevel();
+    if(high != pulseHigh) {
+      pulseEdge(high, clockMicros());
+    }
+  }
+  unsigned long now = millis();
+  for(uint8_t i = 0; i < inputCount; i++) {
+    Input &in = inputs[i];
+    bool level = inputRead(in);
+    if(in.interrupt && level != in.raw) {
+      in.raw = level;
+      in.edgeMillis = now;
+    }
+  }
+}
+
+// Enable the pin change interrupt for a pin, if it has one on the PCINT0 vector
+static bool inputEnableInterrupt(uint8_t pin) {
+#if defined(__AVR_ATtiny85__)
+  if(pin > 5) return false;
+  PCMSK |= _BV(pin);          // digital pin n is PBn
+  GIMSK |= _BV(PCIE);
+  return true;
+#elif defined(digitalPinToPCICR)
+  volatile uint8_t *pcicr = digitalPinToPCICR(pin);
+  if(!pcicr || digitalPinToPCICRbit(pin) != 0) return false;
+  *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  *pcicr |= _BV(digitalPinToPCICRbit(pin));
+  return true;
+#else
+  (void)pin;
+  return false;
+#endif
+}
+#endif
+
+uint8_t inputBegin(uint8_t pin, bool pullup, uint16_t repeat) {
+  Input &in = inputs[inputCount];
+  pinMode(pin, pullup ? INPUT_PULLUP : INPUT);
+  in.pin = pin;
+#ifdef __AVR__
+  in.port = portInputRegister(digitalPinToPort(pin));
+  in.mask = digitalPinToBitMask(pin);
+#endif
+  in.raw = false;               // start released, so an input held low at boot sends a press
+  in.edgeMillis = millis();
+  in.pressed = false;
+  in.repeat = repeat;
+  in.holdMillis = 0;
+  in.interrupt = false;
+  inputCount++;
+#ifdef __AVR__
+  noInterrupts();
+  in.interrupt = inputEnableInterrupt(pin);
+  in.raw = inputRead(in);
+  in.edgeMillis = millis() - DEBOUNCEDELAY;  // current level is already settled
+  interrupts();
+#endif
+  return inputCount - 1;
+}
+
+InputEvent inputUpdate(uint8_t input, unsigned long now) {
+  Input &in = inputs[input];
+  bool raw;
+  unsigned long edge;
+
+  if(!in.interrupt) {                 // polled pin: look for an edge now
+    bool level = inputRead(in);
+    if(level != in.raw) {
+      in.raw = level;
+      in.edgeMillis = now;
+    }
+  }
+  noInterrupts();
+  raw = in.raw;
+  edge = in.edgeMillis;
+  interrupts();
+
+  if(raw != in.pressed) {
+    if(now - edge < DEBOUNCEDELAY) {  // still bouncing
+      return INPUT_NONE;
+    }
+    in.pressed = raw;
+    in.holdMillis = now;
+    return raw ? INPUT_PRESS : INPUT_RELEASE;
+  }
+  if(in.pressed && in.repeat && now - in.holdMillis >= in.repeat) {
+    in.holdMillis = now;
+    return INPUT_HOLD;
+  }
+  return INPUT_NONE;
+}
+
+bool inputPressed(uint8_t input) {
+  return inputs[input].pressed;
+}
+
+bool pulseBegin(uint8_t pin) {
+  pinMode(pin, INPUT);          // receivers and FCs drive the line both ways
+  pulsePin = pin;
+#ifdef __AVR__
+  pulsePort = portInputRegister(digitalPinToPort(pin));
+  pulseMask = digitalPinToBitMask(pin);
+  noInterrupts();
+  pulseHigh = pulseLevel();
+  pulseInterrupt = inputEnableInterrupt(pin);
+  interrupts();
+#else
+  pulseHigh = pulseLevel();
+#endif
+  return pulseInterrupt;
+}
+
+bool pulseRead(uint16_t &width) {
+  if(!pulseInterrupt) {         // polled pin: look for an edge now
+    bool high = pulseLevel();
+    if(high != pulseHigh) {
+      pulseEdge(high, clockMicros());
+    }
+  }
+  noInterrupts();
+  bool fresh = pulseNew;
+  width = pulseWidth;
+  pulseNew = false;
+  interrupts();
+  return fresh;
+}
+
+void pulseBlackout(bool dark) {
+  pulseDark = dark;
+}
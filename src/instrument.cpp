@@ -0,0 +1,175 @@
+// Frame timing instrumentation, see instrument.h
+#include <Arduino.h>
+#include "instrument.h"
+#include "scheduler.h"
+
+#if !defined(__AVR__)
+  #include <stdio.h>
+#endif
+
+struct InstrumentFrame {
+  uint8_t  pattern;
+  uint8_t  skips;                       // frames dropped after this one (saturates)
+  uint16_t us[INSTR_SECTIONS];          // longest run of each section (saturates)
+};
+
+static InstrumentFrame instrumentRing[INSTRUMENT_RING];
+static uint8_t         instrumentHead = 0;     // next ring slot
+static uint8_t         instrumentFrames = 0;   // frames in the ring
+static uint16_t        instrumentHist[INSTR_SECTIONS][INSTRUMENT_BUCKETS];
+static unsigned long   instrumentStarted[INSTR_SECTIONS];
+static uint16_t        instrumentLongest[INSTR_SECTIONS];  // of the frame being rendered
+static uint16_t        instrumentSkips = 0;    // frameSkips at the last frame
+static unsigned long   instrumentDumpMillis = 0;
+static unsigned long   instrumentDumped = 0;
+
+// OUTPUT ////////////////////////////////////////////////
+
+#if defined(__AVR_ATtiny85__)
+// No UART: 8N1 bit-banged on the pin, interrupts off for one byte (~175us at 57600, less than a millis() tick)
+static volatile uint8_t *instrumentPort;
+static uint8_t           instrumentMask;
+
+static void instrumentOutBegin(uint8_t pin) {
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, HIGH);              // idle high
+  instrumentPort = portOutputRegister(digitalPinToPort(pin));
+  instrumentMask = digitalPinToBitMask(pin);
+}
+
+static void instrumentPut(char c) {
+  uint16_t bits = ((uint16_t)(uint8_t)c << 1) | 0x200;   // start bit, 8 data bits lsb first, stop bit
+  uint8_t  sreg = SREG;
+  noInterrupts();
+  for(uint8_t i=0; i < 10; i++) {
+    if(bits & 1) {
+      *instrumentPort |= instrumentMask;
+    }
+    else {
+      *instrumentPort &= ~instrumentMask;
+    }
+    bits >>= 1;
+    __builtin_avr_delay_cycles(F_CPU / INSTRUMENT_BAUD - 12);  // less the loop's own cycles
+  }
+  SREG = sreg;
+}
+#elif defined(__AVR__)
+static void instrumentOutBegin(uint8_t pin) {
+  (void)pin;
+  Serial.begin(INSTRUMENT_BAUD);
+}
+
+static void instrumentPut(char c) {
+  Serial.write(c);
+}
+#else
+static void instrumentOutBegin(uint8_t pin) {
+  (void)pin;
+}
+
+static void instrumentPut(char c) {
+  putchar(c);
+}
+#endif
+
+static void instrumentText(const char *text) {
+  while(*text) {
+    instrumentPut(*text++);
+  }
+}
+
+static void instrumentNumber(uint16_t n) {
+  char digits[6];
+  uint8_t i = 0;
+  do {
+    digits[i++] = '0' + n % 10;
+    n /= 10;
+  } while(n);
+  instrumentPut(' ');
+  while(i) {
+    instrumentPut(digits[--i]);
+  }
+}
+
+// RECORDING ////////////////////////////////////////////////
+
+void instrumentBegin(uint8_t pin, unsigned long dumpMillis) {
+  instrumentOutBegin(pin);
+  instrumentDumpMillis = dumpMillis;
+  instrumentSkips = frameSkips;
+}
+
+void instrumentStart(uint8_t section) {
+  instrumentStarted[section] = clockMicros();
+}
+
+void instrumentStop(uint8_t section) {
+  unsigned long us = clockMicros() - instrumentStarted[section];
+  uint8_t bucket = 0;
+  for(unsigned long limit = 64; bucket < INSTRUMENT_BUCKETS - 1 && us >= limit; limit <<= 1) {
+    bucket++;
+  }
+  uint16_t &count = instrumentHist[section][bucket];
+  if(count != 0xFFFF) {
+    count++;
+  }
+  if(us > 0xFFFF) {
+    us = 0xFFFF;
+  }
+  if(us > instrumentLongest[section]) {
+    instrumentLongest[section] = us;
+  }
+}
+
+void instrumentFrame(uint8_t pattern) {
+  InstrumentFrame &f = instrumentRing[instrumentHead];
+  uint16_t skips = frameSkips - instrumentSkips;
+  instrumentSkips = frameSkips;
+  f.pattern = pattern;
+  f.skips = skips > 0xFF ? 0xFF : skips;
+  for(uint8_t i=0; i < INSTR_SECTIONS; i++) {
+    f.us[i] = instrumentLongest[i];
+    instrumentLongest[i] = 0;
+  }
+  instrumentHead = (instrumentHead + 1) % INSTRUMENT_RING;
+  if(instrumentFrames < INSTRUMENT_RING) {
+    instrumentFrames++;
+  }
+}
+
+// DUMP ////////////////////////////////////////////////
+
+// Text, one record per line:
+//   f <pattern> <render us> <show us> <input us> <frames dropped>   last frames, oldest first
+//   h <section> <count per bucket...>                               since the last dump (0 render, 1 show, 2 input)
+//   s <frameSkips>
+void instrumentPoll(unsigned long now) {
+  if(now - instrumentDumped < instrumentDumpMillis) {
+    return;
+  }
+  instrumentDumped = now;
+  for(uint8_t n=0; n < instrumentFrames; n++) {
+    const InstrumentFrame &f = instrumentRing[(instrumentHead + INSTRUMENT_RING - instrumentFrames + n) % INSTRUMENT_RING];
+    instrumentText("f");
+    instrumentNumber(f.pattern);
+    for(uint8_t i=0; i < INSTR_SECTIONS; i++) {
+      instrumentNumber(f.us[i]);
+    }
+    instrumentNumber(f.skips);
+    instrumentText("\r\n");
+  }
+  for(uint8_t i=0; i < INSTR_SECTIONS; i++) {
+    instrumentText("h");
+    instrumentNumber(i);
+    for(uint8_t b=0; b < INSTRUMENT_BUCKETS; b++) {
+      instrumentNumber(instrumentHist[i][b]);
+      instrumentHist[i][b] = 0;
+    }
+    instrumentText("\r\n");
+  }
+  instrumentText("s");
+  instrumentNumber(frameSkips);
+  instrumentText("\r\n");
+  instrumentFrames = 0;
+  frameRestart(clockMillis());          // the dump's own time is not a missed frame deadline
+}
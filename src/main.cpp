@@ -17,11 +17,12 @@
 // If the toggle pin is not used (left disconnected), the strip will always remain on (there is a blank pattern included that can still be used for off).
 
 // This code stores the the locked pattern in eeprom only after a button release. EEPROM is read at boot, and the last locked pattern is restored.
-// EEPROM writes use wear leveling methods to prolong the life of the chip.
-// On the first boot, if EEPROM is all 0's or the first non-zero value is invalid, the default pattern is used and stored in address 0.
+// EEPROM writes use wear leveling methods to prolong the life of the chip: each save is a new CRC checked record in the next slot (see settings.h).
+// On the first boot, or if no valid record is found, the default pattern is used and saved.
 
-// Adding patterns: Keep all functions non-blocking, add a case to the switch code, and change TOTALPATTERNS to match the range of patterns available.
-// Ex: If the last switch case is 17: TOTALPATTERNS 17
+// Adding patterns: Keep all renderer functions non-blocking, write them as templates on the strip configuration (see config.h),
+// and add a line for them (as renderer<Config>) to the patterns[] table.
+// The number of patterns is counted from the table.
 
 // ATINY85 notes:
 // Add the url to the Arduino package manager in Preferences:
@@ -49,68 +50,311 @@
  #include <avr/power.h> // Required for 16 MHz Adafruit Trinket
 #endif
 #include <EEPROM.h>
+#include <util/crc16.h>
+#include "profile.h"
+#include "wheel.h"
+#include "noise.h"
+#include "gamma.h"
+#include "config.h"
+#include "pattern.h"
+#include "topology.h"
+#include "bytecode.h"
+#include "programs.h"
+#include "pixelbuffer.h"
+#include "blend.h"
+#include "power.h"
+#include "streamout.h"
+#include "parallelout.h"
+#include "settings.h"
+#include "input.h"
+#include "scheduler.h"
+#include "instrument.h"
+#include "msp.h"
 
 // USER CONFIGURATION ////////////////////////////////////////////////
 
-// Pick only one board type uncomment it, and comment out the rest.
+// Board type. Each PlatformIO env sets one (digispark-tiny, beetle, nano). In the Arduino IDE, uncomment one (DIGISPARK if none is).
   //#define BEETLE
-  #define DIGISPARK
+  //#define DIGISPARK
   //#define NANO
 
-#define LED_COUNT 74      // Total number of leds on the strip (pavopro = 77, pavo20 = 74)
-#define BRIGHTNESS 255    // brightness level of the leds, from 0-255.
-#define MODEDELAY 2000    // millis to wait between checking the toggle and mode pins (set to longer for modes that take longer to visualize/complete)
-#define TOGGLEDELAY 200   // enough to debounce or otherwise delay toggling on/off of LED's
+#ifndef LED_COUNT
+  #define LED_COUNT 74    // Total number of leds on the strip (pavopro = 77, pavo20 = 74)
+#endif
+#define BRIGHTNESS 255    // brightness level of the leds on the first boot, from 0-255 (after that the saved level is used)
+#define BRIGHTLEVELS 255, 128, 64, 32, 16, 8  // brightness levels stepped through by a toggle tap, brightest first
+#define BRIGHTTAPDELAY 500 // millis: turning the toggle off and on again quicker than this steps to the next brightness level (and saves it)
+//#define POWERBUDGET 1500  // define to keep the strip's estimated current under this many mA, frames over it are dimmed (see power.h)
+#define RAMRESERVE 192    // bytes of SRAM kept for globals and the stack. The brightness table (256 bytes) is kept in RAM only if it fits as well
+#define MODEDELAY 2000    // millis between pattern changes while the mode pin is held low (set to longer for modes that take longer to visualize/complete)
+#define MODESTARTDELAY 8000 // millis after boot before the mode pin is used (some FC's hold the pin low until blheli music finishes playing)
+#define KEEPALIVEDELAY 1000 // millis between resending an unchanged frame (static patterns refresh at this rate)
 //#define USEBETAFLIGHT     // define when using FC pinio for control (push/pull signal), comment out if using physical buttons to ground.
+//#define NOISEEFFECTS      // define to add the fire, plasma, twinkle and sparkle patterns (include/noise.h). Left out by default to save flash on the Digispark
+//#define PATTERNPROGRAMS   // define to add the bytecode program patterns (include/programs.pat) and their interpreter. Left out by default to save flash on the Digispark
+//#define STREAMOUTPUT      // define to send pixels as they are computed, with no frame buffer in RAM (LED_COUNT is then only limited by frame time)
+//#define PARALLELOUTPUT    // define to send to several strips at once (one per arm), frame time is then set by the longest strip
+#define PARALLELSTRIPS {{0, 37}, {4, 37}} // {pin, leds} of each strip for PARALLELOUTPUT, up to 4 on one port (DIGISPARK: 0 and 4, 3 is USB D- and rounds the edges off), leds add up to LED_COUNT
+//#define TRANSITION TRANSITION_FADE // define to blend from one pattern to the next (TRANSITION_FADE, TRANSITION_WIPE or TRANSITION_DISSOLVE). Needs RAM for a second frame buffer
+#define TRANSITIONTIME 400 // millis a pattern transition takes
+#define TRANSITIONFRAME 20 // millis between frames during a transition (at most)
+//#define TOPOLOGY          // define to lay the strip out on the airframe (segments in topology[] below), so patterns draw one side and it is copied to the other
+//#define INSTRUMENT        // define to time render, show and input handling on the board, and dump the numbers every INSTRUMENTDUMP (see instrument.h)
+#define INSTRUMENTDUMP 5000 // millis between INSTRUMENT dumps
+#define INSTRUMENTPIN 4   // DIGISPARK pin the INSTRUMENT dump is sent on (57600 8N1), the other boards use Serial
+//#define USEMSP            // define to read arming, throttle and battery voltage from the FC over MSP (BEETLE and NANO UART, see msp.h)
+#define MSPLOWCELL 350    // 1/100 V per cell: below this USEMSP flashes the low battery warning over any pattern (0 for no warning)
+//#define MSPTHROTTLEBRIGHT // define to dim the strip with the throttle while armed (USEMSP), full brightness at full throttle
+#define MSPTHROTTLEFLOOR 64 // brightness at zero throttle with MSPTHROTTLEBRIGHT, out of 255
+//#define RCINPUT RC_PATTERN // define to read an RC servo pulse (receiver channel or FC servo/PWM output) on the mode pin instead of a button: RC_PATTERN or RC_BRIGHTNESS
+//#define RCPIN 11          // pin for RCINPUT, if not the mode pin (BEETLE: A0 has no pin change interrupt, use 11)
+#define RCLOW 1000        // microseconds: RCINPUT pulse widths from RCLOW to RCHIGH are split into one band per pattern (or brightness level)
+#define RCHIGH 2000
+#define RCHYSTERESIS 10   // microseconds a pulse must be inside a new band to select it (no flicker between two at a band edge)
+#define RCSETTLEDELAY 2000 // millis a new RCINPUT selection must be held before it is saved (sweeping the stick doesn't wear the EEPROM)
 
 // END USER CONFIGURATION ////////////////////////////////////////////////
 
-// Pin definitions based on board selection
+// Pin definitions based on board selection: BoardPins<LED signal, mode button/fc signal, on/off button/fc signal>
+#if !defined(BEETLE) && !defined(DIGISPARK) && !defined(NANO)
+  #define DIGISPARK
+#endif
+#if defined(BEETLE) + defined(DIGISPARK) + defined(NANO) > 1
+  #error "Pick only one board type"
+#endif
 #ifdef BEETLE
-  #define LED_PIN 9         // Pin used for the LED signal (9 for beetle, 2 for nano, 0 for DIGISPARK)
-  #define MODEPIN A0        // Pin for the mode button/fc signal (A0 for beetle, 12 for nano, 1 for DIGISPARK)
-  #define TOGGLEPIN 10      // Pin for the on/off button/fc signal (10 for beetle, 13 for nano, 2 for DIGISPARK)
+  typedef BoardPins<9, A0, 10> Board;
 #endif
 #ifdef DIGISPARK
-  #define LED_PIN 0         // Pin used for the LED signal (9 for beetle, 2 for nano, 0 for DIGISPARK)
-  #define MODEPIN 1         // Pin for the mode button/fc signal (A0 for beetle, 12 for nano, 1 for DIGISPARK... note remove LED from middle of board)
-  #define TOGGLEPIN 2       // Pin for the on/off button/fc signal (10 for beetle, 13 for nano, 2 for DIGISPARK)
+  typedef BoardPins<0, 1, 2> Board;     // mode pin 1: remove the LED from the middle of the board
 #endif
 #ifdef NANO
-  #define LED_PIN 2         // Pin used for the LED signal (9 for beetle, 2 for nano, 0 for DIGISPARK)
-  #define MODEPIN 12        // Pin for the mode button/fc signal (A0 for beetle, 12 for nano, 1 for DIGISPARK)
-  #define TOGGLEPIN 13      // Pin for the on/off button/fc signal (10 for beetle, 13 for nano, 2 for DIGISPARK)
+  typedef BoardPins<2, 12, 13> Board;
 #endif
 
-// Number of patterns available. Controls mode loop size (!!! increment when adding patterns to the code !!!)
-#define TOTALPATTERNS 13
+#ifdef USEMSP
+  #ifdef __AVR_ATtiny85__
+    #error "USEMSP needs a UART, use a BEETLE or NANO"
+  #endif
+  #if defined(NANO) && defined(INSTRUMENT)
+    #error "The Nano has one UART, USEMSP and INSTRUMENT can't both use it"
+  #endif
+#endif
 
-Adafruit_NeoPixel strip(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);  // "NEO_GRB + NEO_KHZ800" works with Amazon 5V 160LED/m 5mm cobb led strips
+#ifdef RCINPUT
+  #ifndef RCPIN
+    #ifdef BEETLE
+      #error "The Beetle's mode pin A0 has no pin change interrupt, define RCPIN 11 and wire the RC signal there"
+    #endif
+    #define RCPIN Config::board::modePin
+  #endif
+  #define RC_BLACKOUT(dark) pulseBlackout(dark)
+#else
+  #define RC_BLACKOUT(dark) ((void)0)
+#endif
+
+#if defined(BYTECODETWINS) && !defined(PATTERNPROGRAMS)
+  #error "BYTECODETWINS are programs, define PATTERNPROGRAMS too"
+#endif
+
+#ifdef TOPOLOGY
+  #ifdef STREAMOUTPUT
+    #error "TOPOLOGY copies segments in the frame buffer, it can't be used with STREAMOUTPUT"
+  #endif
+  // Segments of the strip in wiring order: {first led, leds, reversed, segment copied}.
+  // A segment that copies itself is drawn by the patterns, in table order, as one strip. A copy repeats the segment
+  // it names (same length), mirrored if 'reversed' differs. Edit this to match how the strip runs around the frame.
+  // Example for 74 leds: 14 led arms, 9 led bars. The left arms copy the right arms, and the front (arm + bar) and
+  // rear (bar + arm) are the two halves the patterns see, so emergency() splits front/rear.
+  enum { ARM_FR, BAR_F, ARM_FL, ARM_RL, BAR_R, ARM_RR };
+  constexpr Segment topology[] PROGMEM = {
+    {0,  14, false, ARM_FR},  // front right arm, hub to tip
+    {14, 9,  false, BAR_F},   // front bar
+    {23, 14, true,  ARM_FR},  // front left arm, tip to hub: mirrors the front right arm
+    {37, 14, false, ARM_RL},  // rear left arm, hub to tip
+    {51, 9,  false, BAR_R},   // rear bar
+    {60, 14, true,  ARM_RL},  // rear right arm, tip to hub: mirrors the rear left arm
+  };
+  #define TOPOLOGYSEGMENTS (sizeof(topology) / sizeof(topology[0]))
+  static_assert(topologyValid(topology, LED_COUNT), "topology[] must cover LED_COUNT leds in order, and copy rendered segments of the same length");
+  #define RENDERCOUNT topologyRendered(topology)
+#else
+  #define RENDERCOUNT LED_COUNT
+#endif
+typedef StripConfig<Board, LED_COUNT, NEO_GRB + NEO_KHZ800, RENDERCOUNT> Config;  // "NEO_GRB + NEO_KHZ800" works with Amazon 5V 160LED/m 5mm cobb led strips
+
+#ifdef PARALLELOUTPUT
+  #ifdef STREAMOUTPUT
+    #error "PARALLELOUTPUT sends from the frame buffer, it can't be used with STREAMOUTPUT"
+  #endif
+  constexpr ParallelStrip parallelStrips[] = PARALLELSTRIPS;  // patterns see these one after the other, as one strip
+  static_assert(parallelTotal(parallelStrips) == LED_COUNT, "PARALLELSTRIPS leds must add up to LED_COUNT");
+#endif
+
+// Pattern renderers (defined further down), templates on the strip configuration
+template <class C> void allOff(const Pattern &p, PatternState &s);
+template <class C> void solidColor(const Pattern &p, PatternState &s);
+template <class C> void colorWipe(const Pattern &p, PatternState &s);
+template <class C> void theaterChase(const Pattern &p, PatternState &s);
+template <class C> void theaterChaseTricolor(const Pattern &p, PatternState &s);
+template <class C> void theaterChaseTricolorWidth(const Pattern &p, PatternState &s);
+template <class C> void theaterChaseTricolorSpaces(const Pattern &p, PatternState &s);
+template <class C> void rainbow(const Pattern &p, PatternState &s);
+template <class C> void rainbowFull(const Pattern &p, PatternState &s);
+template <class C> void theaterChaseRainbow(const Pattern &p, PatternState &s);
+template <class C> void flashingColor(const Pattern &p, PatternState &s);
+template <class C> void emergency(const Pattern &p, PatternState &s);
+template <class C> void alternatingBands(const Pattern &p, PatternState &s);
+template <class C> void fire(const Pattern &p, PatternState &s);
+template <class C> void plasma(const Pattern &p, PatternState &s);
+template <class C> void twinkle(const Pattern &p, PatternState &s);
+template <class C> void sparkle(const Pattern &p, PatternState &s);
+template <class C> void program(const Pattern &p, PatternState &s);
+template <class C> void throttleBar(const Pattern &p, PatternState &s);
+
+void levelBuild(uint8_t brightness);  // Brightness pipeline (defined further down)
+
+// PATTERNS ////////////////////////////////////////////////
+// Each line is one pattern, selected in order by the mode pin (the first line is pattern 1):
+// {renderer, {rgb(red, green, blue), ...}, width, perSecond(steps), millis between frames}
+// or {program<Config>, {}, 0, perSecond(steps), millis between frames, program} for a bytecode program (include/programs.pat)
+// Change colors by editing the color numbers to any value between 0-255.
+// See this page to get color codes: https://www.google.com/search?q=rgb+color+picker
+// perSecond() is the pattern's speed (higher is faster): hues per second for rainbows, pixels per second for chases
+// and wipes, color swaps per second for flashes. It is measured in time, so it does not change with strip length.
+// The last number is milliseconds between frames. Lower is smoother (and busier), it does not change the speed.
+// Width is only used by the band/cluster patterns, colors only by patterns that take colors.
+// You can copy/paste/modify lines to make variations, or add a line with a custom renderer function.
+// The number of patterns is counted automatically. The numbers below are with every option defined: patterns an
+// option leaves out (NOISEEFFECTS, PATTERNPROGRAMS...) move the ones after them up.
+const Pattern patterns[] PROGMEM = {
+  {allOff<Config>,                     {},                                                      0,  perSecond(0),   KEEPALIVEDELAY}, // 1: all off
+  {rainbowFull<Config>,                {},                                                      0,  perSecond(256), 5},   // 2: default pattern, rainbow with all colors shown at once
+  {theaterChaseTricolor<Config>,       {rgb(255, 0, 0), rgb(255, 255, 255), rgb(0, 0, 255)},    0,  perSecond(20),  50},  // 3: Red white and blue
+  {rainbow<Config>,                    {},                                                      0,  perSecond(200), 5},   // 4: Rainbow incrementing one color per led (256 colors)
+  {theaterChaseRainbow<Config>,        {},                                                      0,  perSecond(20),  50},  // 5: Rainbow-enhanced theaterChase variant
+  {colorWipe<Config>,                  {rgb(0, 255, 0)},                                        0,  perSecond(100), 10},  // 6: Green wipe
+  {theaterChaseTricolorSpaces<Config>, {rgb(255, 0, 0), rgb(255, 255, 255), rgb(0, 0, 255)},    0,  perSecond(40),  25},  // 7: Red white and blue clusters
+  {solidColor<Config>,                 {rgb(255, 255, 255)},                                    0,  perSecond(0),   KEEPALIVEDELAY}, // 8: solid white
+  {flashingColor<Config>,              {rgb(255, 255, 255)},                                    0,  perSecond(5),   200}, // 9: flashing solid white
+  {theaterChase<Config>,               {rgb(255, 0, 0)},                                        0,  perSecond(20),  50},  // 10: Red theater chase
+  {emergency<Config>,                  {rgb(255, 0, 0), rgb(0, 0, 255)},                        0,  perSecond(10),  100}, // 11: alternating halves, red and blue
+  {alternatingBands<Config>,           {rgb(245, 200, 66), rgb(0, 0, 255)},                     10, perSecond(10),  100}, // 12: alternating yellow & blue 10 pixel wide bands
+  {theaterChaseTricolorWidth<Config>,  {rgb(168, 117, 0), rgb(255, 14, 89), rgb(43, 198, 57)},  3,  perSecond(50),  20},  // 13: theater chase, 3 color bands 3 wide (sacmob Y P G)
+#ifdef PATTERNPROGRAMS
+  {program<Config>,                    {},                                                      0,  perSecond(2),   100, navLights}, // 14: red/green halves flashing white
+#endif
+#ifdef NOISEEFFECTS
+#ifndef STREAMOUTPUT  // per led noise math is too slow to stream between pixels (see streamout.h)
+  {fire<Config>,                       {},                                                      0,  perSecond(100), 20},  // 15: fire rising from the first led
+  {plasma<Config>,                     {},                                                      4,  perSecond(60),  20},  // 16: drifting rainbow plasma, width is the detail (a blob every 16/width leds)
+  {twinkle<Config>,                    {rgb(255, 180, 80)},                                     0,  perSecond(200), 20},  // 17: warm white twinkling stars
+#endif
+  {sparkle<Config>,                    {rgb(255, 255, 255), rgb(0, 0, 24)},                     12, perSecond(0),   30},  // 18: white sparkles on dim blue, width is sparkles per 256 leds per frame
+#endif
+#ifdef BYTECODETWINS  // programs that draw the same frames as patterns 2, 3 and 5, to compare interpreter cost (sim/bytecode.sh)
+  {program<Config>,                    {},                                                      0,  perSecond(256), 5,   rainbowFullProgram},   // 19: = 2
+  {program<Config>,                    {},                                                      0,  perSecond(20),  50,  tricolorChaseProgram}, // 20: = 3
+  {program<Config>,                    {},                                                      0,  perSecond(20),  50,  rainbowChaseProgram},  // 21: = 5
+#endif
+#ifdef USEMSP
+  {throttleBar<Config>,                {rgb(0, 255, 0), rgb(0, 0, 32)},                         0,  perSecond(0),   20},  // last (after the BYTECODETWINS ones): throttle gauge, green on dim blue
+#endif
+};
+#ifdef USEMSP
+const Pattern lowBatteryPattern PROGMEM = {flashingColor<Config>, {rgb(255, 80, 0)}, 0, perSecond(6), 50};  // amber flash, shown over any pattern while the battery is low
+#endif
+const Pattern errorPattern PROGMEM = {flashingColor<Config>, {rgb(255, 0, 0)}, 0, perSecond(100), 10};  // fast flashing solid red, shown for an invalid pattern number
+
+// Number of patterns available, controls the mode loop size
+#define TOTALPATTERNS (sizeof(patterns) / sizeof(patterns[0]))
+extern const uint8_t totalPatterns = TOTALPATTERNS;  // same count, visible to the host benchmark
+extern const uint16_t pixelNumber = Config::count;   // leds the patterns draw, visible to the host benchmark
+
+// END PATTERNS ////////////////////////////////////////////////
+
+constexpr WheelTable              wheelTable PROGMEM = WheelTable();                 // Wheel() colors, generated at compile time
+constexpr RainbowTable<Config::count> rainbowTable PROGMEM = RainbowTable<Config::count>(); // rainbowFull() hue offset of each pixel
+
+#ifdef STREAMOUTPUT
+  Adafruit_NeoPixel strip(0, Config::board::ledPin, Config::type);  // only used for pin setup and brightness, pixels go out through streamout.h
+#else
+  Adafruit_NeoPixel strip(Config::leds, Config::board::ledPin, Config::type);
+#endif
+
+// Gamma + brightness: channel value to output level. In RAM, rebuilt when the brightness changes, where it fits
+// next to the frame buffer. Otherwise every color conversion scales the flash gamma table (one multiply per channel).
+constexpr GammaTable gammaTable PROGMEM = GammaTable();
+const uint8_t        brightLevels[] PROGMEM = {BRIGHTLEVELS};
+#ifdef STREAMOUTPUT
+  constexpr uint16_t frameBufferBytes = 0;
+#else
+  constexpr uint16_t frameBufferBytes = Config::bufferBytes;
+#endif
+#ifdef TRANSITION
+  #ifdef STREAMOUTPUT
+    #error "TRANSITION blends frame buffers, it can't be used with STREAMOUTPUT"
+  #endif
+  constexpr uint16_t transitionBytes = Config::bufferBytes;
+  static_assert(frameBufferBytes + transitionBytes + RAMRESERVE <= ramSize,
+                "TRANSITION: no room for the second frame buffer, use fewer leds or undefine TRANSITION");
+#else
+  constexpr uint16_t transitionBytes = 0;
+#endif
+constexpr bool levelTableInRam = frameBufferBytes + transitionBytes + 256UL + RAMRESERVE <= ramSize;
+uint8_t        levelTable[levelTableInRam ? 256 : 1];
 
-unsigned long pixelPrevious = 0;        // Previous Pixel Millis
 uint8_t       pattern = 0;              // Current Pattern Number
 unsigned long pixelInterval = 50;       // Pixel Interval (ms)
-int           pixelQueue = 0;           // Pattern Pixel Queue
-int           pixelCycle = 0;           // Pattern Pixel Cycle
-uint16_t      pixelNumber = LED_COUNT;  // Total Number of Pixels
-unsigned long currentModeMillis = 8000; // Millis when the mode pin was last read (some FC's that hold pin low until blheli music finishes playing... init with 8000 to delay reading mode pin after boot.)
-unsigned long currentToggleMillis = 0;  // Millis when the mode pin was last read
 unsigned long currentMillis = 0;        // Storage of millis for each loop
-bool          modeState = 0;            // High/Low state of the mode pin for current loop
-bool          modeStatePrevious = 0;    // High/Low state of the mode pin from previous loop
-bool          toggleState = 0;          // High/Low state of the toggle pin for current loop
-bool          toggleStatePrevious = 0;  // High/Low state of the toggle pin from previous loop
-bool          ledColorOff = 0;          // Switch to toggle between color on and color off (used for wipes, flashes, etc)
-int           eepromAddress = 0;        // Storage for the currently used eepromAddress
+uint8_t       modeInput = 0;            // Input index of the mode pin (see input.h)
+uint8_t       toggleInput = 0;          // Input index of the toggle pin
+SettingsRecord settings;                // Saved settings, cached in RAM so only saves touch EEPROM
+uint16_t      frameSignature = 0;       // CRC of the last frame sent to the strip
+unsigned long frameShownMillis = 0;     // Millis when a frame was last sent to the strip
+uint8_t       patternRendered = 0;      // Pattern that rendered the last frame (a new pattern renders right away)
+PatternState  patternState;             // State of the current pattern, shared by all patterns (see pattern.h)
+unsigned long toggleMillis = 0;         // Millis the toggle pin was last pulled low (for brightness taps)
+#ifdef TRANSITION
+uint8_t       transitionFrom[transitionBytes];  // Last frame of the old pattern, blended into the new one's frames
+unsigned long transitionMillis = 0;     // Millis the transition started
+bool          transitionActive = false; // A transition is in progress
+#endif
+uint8_t       levelBrightness = 0;      // Brightness the level table is built for
+uint8_t       levelOutput = 0;          // and the one it is built at (lower while STREAMOUTPUT's power limit dims)
+#ifdef POWERBUDGET
+uint32_t      frameLoad = 0;            // Channel levels written this frame (see power.h)
+#ifdef STREAMOUTPUT
+uint8_t       powerDim = 255;           // Brightness scale (of 256, minus 1) the power limit streams frames at
+unsigned long powerNeededMillis = 0;    // Millis a frame last needed that dim
+#endif
+#endif
+#ifdef USEMSP
+bool          mspLowBattery = false;    // Battery under MSPLOWCELL per cell (telemetry from the FC)
+uint8_t       mspCells = 0;             // Cells of the battery, counted from the first voltage reported
+#endif
+#ifdef RCINPUT
+uint8_t       rcBandSeen = 0xFF;        // Band of the last RC pulse (a band is selected when two pulses in a row agree)
+uint8_t       rcBandSelected = 0xFF;    // Band selected now
+unsigned long rcSelectMillis = 0;       // Millis it was selected
+bool          rcUnsaved = false;        // The selection differs from the saved settings
+#endif
 
 void setup() {
   // No pullups needed on pins when using an FC for input. Betaflight pinio uses push/pull for output (actively drives both high and low).
   #ifdef USEBETAFLIGHT
-    pinMode(MODEPIN,INPUT);          //  mode select push/pull signal.
-    pinMode(TOGGLEPIN,INPUT);        //  toggle push/pull signal.
+    #ifndef RCINPUT
+      modeInput = inputBegin(Config::board::modePin, false, MODEDELAY);   //  mode select push/pull signal, repeats while low.
+    #endif
+    toggleInput = inputBegin(Config::board::togglePin, false, 0);         //  toggle push/pull signal.
   #else
-    pinMode(MODEPIN,INPUT_PULLUP);   //  mode select button to ground.
-    pinMode(TOGGLEPIN,INPUT_PULLUP); //  toggle button to ground.
+    #ifndef RCINPUT
+      modeInput = inputBegin(Config::board::modePin, true, MODEDELAY);    //  mode select button to ground, repeats while held.
+    #endif
+    toggleInput = inputBegin(Config::board::togglePin, true, 0);          //  toggle button to ground.
+  #endif
+  #ifdef RCINPUT
+    pulseBegin(RCPIN);                                                    //  RC servo pulse selects the pattern or brightness.
   #endif
 
   // These lines are specifically to support the Adafruit Trinket 5V 16 MHz.
@@ -121,487 +365,919 @@ void setup() {
   // END of Trinket-specific code.
 
   strip.begin();           // INITIALIZE NeoPixel strip object (REQUIRED)
-  strip.show();            // Turn OFF all pixels ASAP
-  strip.setBrightness(BRIGHTNESS);
-
-  while(!pattern) {        // Load a saved pattern from EEPROM
-    pattern = EEPROM.read(eepromAddress);  // Read the address (starts at 0)
-    // zero value at this address... increment address
-    if(!pattern)  {                        
-      eepromAddress++;
-    }
-    // eeprom is blank or contains an invalid first non-zero value, save default pattern to address 0  (usually just the first boot)
-    if (eepromAddress >= EEPROM.length() || pattern > TOTALPATTERNS) { 
-      eepromAddress = 0;
-      pattern = 2;    // default pattern
-      EEPROM.write(eepromAddress,pattern);
-    }
+  #ifdef PARALLELOUTPUT
+    parallelBegin(parallelStrips, sizeof(parallelStrips) / sizeof(parallelStrips[0]));
+    parallelShow(strip.getPixels());  // Turn OFF all pixels ASAP
+  #else
+    strip.show();          // Turn OFF all pixels ASAP
+  #endif
+
+  // Load the saved settings from EEPROM. If there are none, or the saved pattern is invalid, save the defaults (usually just the first boot)
+  if(!settingsLoad(settings) || settings.pattern < 1 || settings.pattern > TOTALPATTERNS) {
+    settings.pattern = 2;    // default pattern
+    settings.brightness = BRIGHTNESS;
+    settingsSave(settings);
   }
+  pattern = settings.pattern;
+  levelBuild(settings.brightness);
+  #ifdef INSTRUMENT
+    instrumentBegin(INSTRUMENTPIN, INSTRUMENTDUMP);
+  #endif
+  #ifdef USEMSP
+    mspBegin();
+  #endif
   // delay(1000); // a startup delay may be required by some FC's to give time for pin states to stabilize
 }
 
 // Some functions of our own for creating animated effects -----------------
 
 // Input a value 0 to 255 to get a color value.
-// The colours are a transition r - g - b - back to r.
+// The colours are a transition r - g - b - back to r (precomputed in wheelTable, see wheel.h).
 uint32_t Wheel(byte WheelPos) {
-  WheelPos = 255 - WheelPos;
-  if(WheelPos < 85) {
-    return strip.Color(255 - WheelPos * 3, 0, WheelPos * 3);
-  }
-  if(WheelPos < 170) {
-    WheelPos -= 85;
-    return strip.Color(0, WheelPos * 3, 255 - WheelPos * 3);
-  }
-  WheelPos -= 170;
-  return strip.Color(WheelPos * 3, 255 - WheelPos * 3, 0);
+  PROF_ENTER(PROF_WHEEL);
+  const uint8_t *rgb = wheelTable.rgb[WheelPos];
+  uint32_t color = strip.Color(pgm_read_byte(&rgb[0]), pgm_read_byte(&rgb[1]), pgm_read_byte(&rgb[2]));
+  PROF_EXIT(PROF_WHEEL);
+  return color;
 }
 
-// Solid Color for the whole strip
-void solidColor(uint32_t color) {
-  for(uint16_t i=0; i < pixelNumber; i++) {
-    strip.setPixelColor(i, color);
-  }
-  strip.show();
-  return;
-}
-// Fill pixels one by one with a solid color, then color off, and repeating
-void colorWipe(uint32_t color, int wait) {
-  static uint16_t current_pixel = 0;
-  pixelInterval = wait;                        //  Update delay time
-  current_pixel++;
-  if(current_pixel >= pixelNumber) {           //  Loop the pattern from the first LED
-    current_pixel = 0;
-    if(!ledColorOff) {
-      ledColorOff = 1;
-    }
-    else  {
-      ledColorOff = 0;
-    }
-  //  patternComplete = true;
+// CRC of the pixel buffer. Plain sums miss frames that only move colors around (chases, swapped halves).
+uint16_t frameChecksum() {
+  const uint8_t *p = strip.getPixels();
+  uint16_t crc = 0xFFFF;
+  for(uint16_t i = Config::leds * 3; i; i--) {
+    crc = _crc_ccitt_update(crc, *p++);
   }
-  if(!ledColorOff)  {
-    strip.setPixelColor(current_pixel, color); //  Set pixel's color (in RAM)
-  }
-  else  {
-    strip.setPixelColor(current_pixel, 0); //  Set pixel's color (in RAM)
-  }
-  strip.show();                                //  Update strip to match
+  return crc;
 }
 
-// Theater-marquee-style chasing lights
-void theaterChase(uint32_t color, int wait) {
-  //static uint32_t loop_count = 0;
-  static uint16_t current_pixel = 0;
-
-  pixelInterval = wait;                   //  Update delay time
-
-  strip.clear();
+#ifdef TRANSITION
+// Start a transition from what the strip shows now to the next pattern (e.g. after a pattern change)
+void transitionStart(unsigned long now) {
+  memcpy(transitionFrom, strip.getPixels(), transitionBytes);
+  transitionMillis = now;
+  transitionActive = true;
+}
 
-  for(uint16_t c=current_pixel; c < pixelNumber; c += 3) {
-    strip.setPixelColor(c, color);
+// Mix the new pattern's frame in the strip buffer with the old pattern's last frame, TRANSITIONTIME long
+void transitionBlend() {
+  if(!transitionActive) {
+    return;
   }
-  strip.show();
-
-  current_pixel++;
-  if (current_pixel >= 3) {
-    current_pixel = 0;
-  //  loop_count++;
+  unsigned long elapsed = currentMillis - transitionMillis;
+  if(elapsed >= TRANSITIONTIME) {
+    transitionActive = false;
+    return;
   }
-
-  //if (loop_count >= 10) {
-  //  current_pixel = 0;
-  //  loop_count = 0;
-  //  patternComplete = true;
-  //}
+  uint8_t mix = elapsed * BLEND_MAX / TRANSITIONTIME;
+  PROF_ENTER(PROF_BLEND);
+  #if TRANSITION == TRANSITION_WIPE
+    wipeBuffer(strip.getPixels(), transitionFrom, (uint32_t)Config::leds * mix / BLEND_MAX, Config::leds);
+  #elif TRANSITION == TRANSITION_DISSOLVE
+    dissolveBuffer(strip.getPixels(), transitionFrom, Config::leds, mix);
+  #else
+    blendBuffer(strip.getPixels(), transitionFrom, transitionBytes, mix);
+  #endif
+  PROF_EXIT(PROF_BLEND);
 }
+#endif
 
-// 3 color theater chasing lights
-void theaterChaseTricolor(uint32_t color1,uint32_t color2,uint32_t color3, int wait) {
-  //static uint32_t loop_count = 0;
-  static uint16_t current_pixel = 0;
-
-  pixelInterval = wait;                   //  Update delay time
-
-  strip.clear();
+#ifdef POWERBUDGET
+static_assert(POWERBUDGET > (uint32_t)LED_MA_IDLE * Config::leds, "POWERBUDGET is less than the dark strip draws");
+constexpr uint32_t powerBudgetLoad = powerBudget(POWERBUDGET, Config::leds);
+#define POWER_ADD(px, count) powerAdd(pixelLoad(px), count)
 
-  for(uint16_t c=current_pixel; c < pixelNumber; c += 3) {
-    strip.setPixelColor(c, color1);
+// Add a run to the frame's load. A single pixel (the per pixel renderers) is a plain add: the 32 bit multiply
+// is a software call on the ATtiny85, so only longer runs pay for it, once per run.
+inline void powerAdd(uint16_t load, uint16_t count) {
+  if(count == 1) {
+    frameLoad += load;
   }
-  for(uint16_t c=current_pixel + 1; c < pixelNumber; c += 3) {
-    strip.setPixelColor(c, color2);
+  else {
+    frameLoad += (uint32_t)load * count;
   }
-  for(uint16_t c=current_pixel + 2; c < pixelNumber; c += 3) {
-    strip.setPixelColor(c, color3);
-  }
-  strip.show();
+}
 
-  current_pixel++;
-  if (current_pixel >= 3) {
-    current_pixel = 0;
-   // loop_count++;
+// Dim the frame in the strip buffer to the budget, if its load is over. Buffered frames only:
+// STREAMOUTPUT has sent the pixels already, so it dims the next frames instead (see frameEnd()).
+void powerLimit() {
+  if(frameLoad > powerBudgetLoad) {
+    PROF_ENTER(PROF_POWER);
+    scaleBuffer(strip.getPixels(), Config::bufferBytes, powerScale(frameLoad, powerBudgetLoad));
+    PROF_EXIT(PROF_POWER);
   }
-
-  //if (loop_count >= 10) {
-  //  current_pixel = 0;
-  //  loop_count = 0;
-   // patternComplete = true;
-  //}
+  frameLoad = 0;
 }
+#ifdef STREAMOUTPUT
+constexpr uint8_t powerStartDim = powerSafeDim(powerBudgetLoad, Config::leds);  // until a frame of the pattern is measured
+#define POWERRELEASE 8    // dim steps the limit has to be able to let go before it does (not a level table rebuild every frame)
+#define POWERHOLD 1000    // millis no frame may need the dim before it is let go (the dark frames of a flashing pattern don't)
+const WirePixel   powerBlack = {};
+#endif
+#else
+#define POWER_ADD(px, count) ((void)0)
+#endif
 
-// theater chasing with 3 color spaced clusters, adjustable width
-void theaterChaseTricolorWidth(uint32_t color1,uint32_t color2,uint32_t color3,uint32_t width, int wait) {
-  //static uint32_t loop_count = 0;
-  static uint16_t current_pixel = 0;
-
-  pixelInterval = wait;                   //  Update delay time
-
-  strip.clear();
-  for(int16_t c=current_pixel-6*width ; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color1);
-    }
+// Send the pixel buffer to the strip, only if it changed since the last frame.
+// show() disables interrupts for ~30us per led, so unchanged frames are skipped
+// and only resent every KEEPALIVEDELAY to recover from any glitched data.
+void showStrip() {
+  #ifdef POWERBUDGET
+    powerLimit();             //  before blending, so both frames of a transition are within budget
+  #endif
+  #ifdef TRANSITION
+    transitionBlend();
+  #endif
+  uint16_t signature = frameChecksum();
+  if(signature == frameSignature && currentMillis - frameShownMillis < KEEPALIVEDELAY) {
+    return;
   }
-  for(int16_t c=current_pixel-5*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
-    }
+  frameSignature = signature;
+  frameShownMillis = currentMillis;
+  INSTR_START(INSTR_SHOW);
+  PROF_ENTER(PROF_SHOW);
+  RC_BLACKOUT(true);
+  #ifdef PARALLELOUTPUT
+    parallelShow(strip.getPixels());
+    PROF_EXIT(PROF_SHOW);
+    clockBlackout(parallelShowMicros());
+  #else
+    strip.show();
+    PROF_EXIT(PROF_SHOW);
+    clockBlackout(Config::showMicros);
+  #endif
+  RC_BLACKOUT(false);                         //  after clockBlackout(), so edges are timed on the corrected clock
+  INSTR_STOP(INSTR_SHOW);
+}
+
+// Output level of a channel value: gamma corrected, then scaled by the brightness. For wire() when the level
+// table is not in RAM, so it runs per channel: the high byte of the gamma entry (little endian) and one 8x8 bit
+// multiply, none at full brightness. Within 1 of the table's 16 bit result.
+uint8_t levelOf(uint8_t value, uint8_t brightness) {
+  uint8_t level = pgm_read_byte((const uint8_t *)&gammaTable.level[value] + 1);
+  if(brightness == 255) {
+    return level;
   }
-  for(int16_t c=current_pixel-4*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color2);
+  return ((uint16_t)level * (uint8_t)(brightness + 1)) >> 8;
+}
+
+// Set the brightness. Rebuilds the level table from the 16 bit gamma entries, so low brightness levels keep
+// distinct steps (a few thousand cycles, only when the brightness changes).
+void levelBuild(uint8_t brightness) {
+  levelBrightness = brightness;
+  #if defined(STREAMOUTPUT) && defined(POWERBUDGET)
+    brightness = ((uint16_t)brightness * (powerDim + 1)) >> 8;   //  the power limit dims streamed frames here, not per pixel
+  #endif
+  levelOutput = brightness;
+  if(levelTableInRam) {
+    for(uint16_t i=0; i < 256; i++) {
+      levelTable[i] = ((uint32_t)pgm_read_word(&gammaTable.level[i]) * (brightness + 1)) >> 16;
     }
   }
-  for(int16_t c=current_pixel-3*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
-    }
+}
+
+// Convert a color to strip wire order through gamma and brightness, for the pixelbuffer.h kernels
+WirePixel wire(uint32_t color) {
+  if(levelTableInRam) {
+    return wireColorTable<Config::type>(color, levelTable);
   }
-  for(int16_t c=current_pixel-2*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color3);
+  return wireColor<Config::type>(rgb(levelOf(color >> 16, levelOutput), levelOf(color >> 8, levelOutput),
+                                     levelOf(color, levelOutput)), 255);
+}
+
+// Frame output. Renderers emit every pixel of a frame once, from the first to the last, as runs of one color:
+// frameBegin(), frameRun(color, count)..., frameEnd().
+// Buffered: runs are written into the strip buffer, and frameEnd() shows it if it changed.
+// STREAMOUTPUT: runs are clocked straight out to the strip, so keep the work between runs small (see streamout.h).
+// TOPOLOGY: runs go to the rendered segments in turn (back to front in a reversed one), and frameEnd() fills the copies.
+#ifdef STREAMOUTPUT
+void frameBegin() {
+  RC_BLACKOUT(true);
+  streamBegin(Config::board::ledPin);
+}
+void frameRun(const WirePixel &px, uint16_t count) {
+  #ifdef POWERBUDGET                    //  load added pixel by pixel (no multiply between pixels), and once the frame
+    uint16_t load = pixelLoad(px);      //  is over budget the rest of it goes out black (the dim is a frame late).
+    uint32_t total = frameLoad;         //  The run's sum is kept in registers, frameLoad is only written after it
+    while(count--) {
+      total += load;
+      streamPixel(total <= powerBudgetLoad ? px : powerBlack);
     }
-  }
-  for(int16_t c=current_pixel-width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
+    frameLoad = total;
+  #else
+    while(count--) {
+      streamPixel(px);
     }
-  }
-  for(int16_t c=current_pixel ; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color1);
+  #endif
+}
+void frameEnd() {
+  streamEnd();
+  clockBlackout(Config::showMicros);
+  RC_BLACKOUT(false);
+  #ifdef POWERBUDGET                    //  dims the next frames so one like this fits, this one is out already
+    uint8_t dim = powerNextDim(frameLoad, powerBudgetLoad, powerDim);
+    if(dim <= powerDim + POWERRELEASE && dim != 255) {
+      powerNeededMillis = currentMillis;
     }
-  }
-  for(int16_t c=current_pixel+width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
+    if(dim < powerDim || (currentMillis - powerNeededMillis >= POWERHOLD && dim != powerDim)) {
+      powerDim = dim;
+      levelBuild(levelBrightness);
     }
-  }
-  for(int16_t c=current_pixel+2*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color2);
+    frameLoad = 0;
+  #endif
+}
+#elif defined(TOPOLOGY)
+Segment  frameSegment;                  // Rendered segment being written
+uint8_t  frameSegmentIndex = 0;         // its index in topology[]
+uint16_t frameSegmentLeft = 0;          // pixels of it still to be written
+void frameBegin() {
+  frameSegmentIndex = 0;
+  frameSegmentLeft = 0;
+}
+#ifdef POWERBUDGET
+uint8_t  frameSegmentShown = 1;         // times the segment is on the strip: itself and its copies
+#endif
+void frameRun(const WirePixel &px, uint16_t count) {
+  while(count) {
+    while(!frameSegmentLeft) {                                     //  next rendered segment
+      memcpy_P(&frameSegment, &topology[frameSegmentIndex], sizeof(frameSegment));
+      if(frameSegment.source == frameSegmentIndex) {
+        frameSegmentLeft = frameSegment.count;
+        #ifdef POWERBUDGET
+          frameSegmentShown = 0;
+          for(uint8_t i=0; i < TOPOLOGYSEGMENTS; i++) {
+            frameSegmentShown += pgm_read_byte(&topology[i].source) == frameSegmentIndex;
+          }
+        #endif
+      }
+      frameSegmentIndex++;
     }
+    uint16_t run = count < frameSegmentLeft ? count : frameSegmentLeft;
+    uint16_t first = frameSegment.reversed ? frameSegment.first + frameSegmentLeft - run
+                                           : frameSegment.first + frameSegment.count - frameSegmentLeft;
+    POWER_ADD(px, run * frameSegmentShown);
+    fillSolid(strip.getPixels(), first, run, px);
+    frameSegmentLeft -= run;
+    count -= run;
   }
-  for(int16_t c=current_pixel+3*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
+}
+void frameEnd() {
+  for(uint8_t i=0; i < TOPOLOGYSEGMENTS; i++) {
+    Segment copy, source;
+    memcpy_P(&copy, &topology[i], sizeof(copy));
+    if(copy.source == i) continue;
+    memcpy_P(&source, &topology[copy.source], sizeof(source));
+    if(copy.reversed == source.reversed) {
+      copyRange(strip.getPixels(), copy.first, source.first, copy.count);
     }
-  }
-  for(int16_t c=current_pixel+4*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++)  {
-      strip.setPixelColor(c+i, color3);
+    else {
+      copyReversed(strip.getPixels(), copy.first, source.first, copy.count);
     }
   }
-  for(int16_t c=current_pixel+5*width; c < pixelNumber; c += 6*width) {
-    for(uint16_t i=0; i < width; i++) {
-      strip.setPixelColor(c+i, 0);
+  showStrip();
+}
+#else
+uint16_t frameCursor = 0;               // Next pixel to be written in the strip buffer
+void frameBegin() {
+  frameCursor = 0;
+}
+void frameRun(const WirePixel &px, uint16_t count) {
+  POWER_ADD(px, count);
+  fillSolid(strip.getPixels(), frameCursor, count, px);
+  frameCursor += count;
+}
+void frameEnd() {
+  showStrip();
+}
+#endif
+
+// Solid Color for the whole strip
+template <class C>
+void solidColor(const Pattern &p, PatternState &s) {
+  frameBegin();
+  frameRun(wire(p.color[0]), C::count);
+  frameEnd();
+}
+
+// Fill pixels one by one with a solid color, then color off, and repeating
+template <class C>
+void colorWipe(const Pattern &p, PatternState &s) {
+  uint16_t position = s.steps % (2 * (uint32_t)C::count);  //  One wipe on, then one wipe off
+  bool colorOff = position >= C::count;
+  uint16_t current_pixel = colorOff ? position - C::count : position;
+  WirePixel on = wire(p.color[0]), off = wire(0);
+  frameBegin();                                //  Wiped part, then what the last wipe left behind
+  frameRun(colorOff ? off : on, current_pixel + 1);
+  frameRun(colorOff ? on : off, C::count - current_pixel - 1);
+  frameEnd();
+}
+
+// Where a repeating sequence of 'count' colors, each one 'width' pixels wide, shifted 'phase' pixels along, starts:
+// pixel i shows sequence position (i - phase) mod (count * width). Sets 'index' to the color of the first pixel and
+// returns the pixels left of it. The divides are done here, before the frame starts (see paletteRun()).
+uint16_t paletteStart(uint8_t count, uint8_t width, uint16_t phase, uint8_t &index) {
+  uint16_t period = count * width;
+  uint16_t start = (period - phase % period) % period;  // sequence position of pixel 0
+  index = start / width;
+  return width - start % width;
+}
+
+// Draw 'pixels' pixels of the sequence, from color 'index' with 'run' pixels left of it (see paletteStart()).
+// Every pixel is written exactly once, as runs of 'width' pixels, so no clear() is needed.
+void paletteRun(const WirePixel *wires, uint8_t count, uint8_t width, uint8_t index, uint16_t run, uint16_t pixels) {
+  while(pixels) {
+    if(run > pixels) run = pixels;
+    frameRun(wires[index], run);
+    pixels -= run;
+    run = width;
+    if(++index >= count) {
+      index = 0;
     }
   }
-  strip.show();
+}
 
-  current_pixel++;
-  if (current_pixel >= 6*width) {
-    current_pixel = 0;
+// Fill the strip with a repeating sequence of colors (see paletteRun()). At most PALETTE_MAX colors.
+#define PALETTE_MAX 8
+template <class C>
+void periodicPalette(const uint32_t *colors, uint8_t count, uint8_t width, uint16_t phase) {
+  WirePixel wires[PALETTE_MAX];
+  for(uint8_t c=0; c < count; c++) {
+    wires[c] = wire(colors[c]);                         // convert once per frame, not once per pixel
   }
+  uint8_t  index;
+  uint16_t run = paletteStart(count, width, phase, index);
+  frameBegin();
+  paletteRun(wires, count, width, index, run, C::count);
+  frameEnd();
 }
 
-// theater chasing lights with 3 color clusters and 3 spaces between
-void theaterChaseTricolorSpaces(uint32_t color1,uint32_t color2,uint32_t color3, int wait) {
-  //static uint32_t loop_count = 0;
-  static uint16_t current_pixel = 0;
-
-  pixelInterval = wait;                   //  Update delay time
+// Theater-marquee-style chasing lights
+template <class C>
+void theaterChase(const Pattern &p, PatternState &s) {
+  const uint32_t colors[3] = {p.color[0], 0, 0};
+  periodicPalette<C>(colors, 3, 1, s.steps % 3);
+}
 
-  strip.clear();
+// 3 color theater chasing lights
+template <class C>
+void theaterChaseTricolor(const Pattern &p, PatternState &s) {
+  periodicPalette<C>(p.color, 3, 1, s.steps % 3);
+}
 
-  for(uint16_t c=current_pixel; c < pixelNumber; c += 6) {
-    strip.setPixelColor(c, color1);
-  }
-  for(uint16_t c=current_pixel + 1; c < pixelNumber; c += 6) {
-    strip.setPixelColor(c, color2);
-  }
-  for(uint16_t c=current_pixel + 2; c < pixelNumber; c += 6) {
-    strip.setPixelColor(c, color3);
-  }
-  for(uint16_t c=current_pixel + 3; c < pixelNumber; c += 6) {
-    strip.setPixelColor(c, 0);
-    strip.setPixelColor(c+1, 0);
-    strip.setPixelColor(c+2, 0);
-  }
-  strip.show();
+// theater chasing with 3 color spaced clusters, adjustable width
+template <class C>
+void theaterChaseTricolorWidth(const Pattern &p, PatternState &s) {
+  const uint32_t colors[6] = {p.color[0], 0, p.color[1], 0, p.color[2], 0};
+  periodicPalette<C>(colors, 6, p.width, s.steps % (6 * p.width));
+}
 
-  current_pixel++;
-  if (current_pixel >= 6) {
-    current_pixel = 0;
-  }
+// theater chasing lights with 3 color clusters and 3 spaces between
+template <class C>
+void theaterChaseTricolorSpaces(const Pattern &p, PatternState &s) {
+  const uint32_t colors[6] = {p.color[0], p.color[1], p.color[2], 0, 0, 0};
+  periodicPalette<C>(colors, 6, 1, s.steps % 6);
 }
 
 // Rainbow cycle, 1 color step between each LED
-void rainbow(uint8_t wait) {
-  if(pixelInterval != wait)
-    pixelInterval = wait;                   
-  for(uint16_t i=0; i < pixelNumber; i++) {
-    strip.setPixelColor(i, Wheel((i + pixelCycle) & 255)); //  Update delay time  
+template <class C>
+void rainbow(const Pattern &p, PatternState &s) {
+  uint8_t hue = s.steps;                    //  Current cycle, loops every 256 steps
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++) {
+    frameRun(wire(Wheel((i + hue) & 255)), 1);
   }
-  strip.show();                             //  Update strip to match
-  pixelCycle++;                             //  Advance current cycle
-  if(pixelCycle >= 256)
-    pixelCycle = 0;                         //  Loop the cycle back to the begining
+  frameEnd();                               //  Update strip to match
 }
 
 // Rainbow cycle with the complete rainbow distributed on the strip
-void rainbowFull(uint8_t wait) {
-  if(pixelInterval != wait)
-    pixelInterval = wait;                   
-  uint16_t i;
-  for(i=0; i< strip.numPixels(); i++) {
-    strip.setPixelColor(i, Wheel(((i * 256 / strip.numPixels()) + pixelCycle) & 255));
-  }
-  strip.show();                             //  Update strip to match
-  pixelCycle++;                             //  Advance current cycle
-  if(pixelCycle >= 256)
-    pixelCycle = 0;                         //  Loop the cycle back to the begining
-}
-
-//Theatre-style crawling lights with rainbow effect
-void theaterChaseRainbow(uint8_t wait) {
-  if(pixelInterval != wait)
-    pixelInterval = wait;                   //  Update delay time  
-  for(uint16_t i=0; i < pixelNumber; i+=3) {
-    strip.setPixelColor(i + pixelQueue, Wheel((i + pixelCycle) % 255)); 
-  }
-  strip.show();
-  for(uint16_t i=0; i < pixelNumber; i+=3) {
-    strip.setPixelColor(i + pixelQueue, strip.Color(0, 0, 0));
-  }      
-  pixelQueue++;                           //  Advance current queue  
-  pixelCycle++;                           //  Advance current cycle
-  if(pixelQueue >= 3)
-    pixelQueue = 0;                       //  Loop
-  if(pixelCycle >= 256)
-    pixelCycle = 0;                       //  Loop
+template <class C>
+void rainbowFull(const Pattern &p, PatternState &s) {
+  uint8_t hue = s.steps;                    //  Current cycle, loops every 256 steps
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++) {
+    frameRun(wire(Wheel(pgm_read_byte(&rainbowTable.hue[i]) + hue)), 1);  // offset table replaces i * 256 / numPixels
+  }
+  frameEnd();                               //  Update strip to match
+}
+
+//Theatre-style crawling lights with rainbow effect (every third led lit, the rest off)
+template <class C>
+void theaterChaseRainbow(const Pattern &p, PatternState &s) {
+  uint8_t queue = s.steps % 3;              //  Chase moves one pixel per step
+  uint8_t hue = s.steps;                    //  and one color per step
+  WirePixel off = wire(0);
+  frameBegin();
+  frameRun(off, queue < C::count ? queue : C::count);
+  for(uint16_t i=0; i + queue < C::count; i+=3) {
+    uint16_t left = C::count - i - queue - 1;
+    frameRun(wire(Wheel((i + hue) & 255)), 1);
+    frameRun(off, left < 2 ? left : 2);
+  }
+  frameEnd();
 }
 
 // Flashing Solid Color for the whole strip
-void flashingColor(uint32_t color, uint8_t wait) {
-  pixelInterval = wait;                   //  Update delay time
-  if(pixelCycle > 1) pixelCycle = 0;
-  if(pixelCycle)  {
-    pixelCycle = 0;
-    for(uint16_t i=0; i < pixelNumber; i++) {
-      strip.setPixelColor(i, 0);
-    }
+template <class C>
+void flashingColor(const Pattern &p, PatternState &s) {
+  bool flash = !(s.steps & 1);              //  Swaps every step, starting lit
+  frameBegin();
+  frameRun(wire(flash ? p.color[0] : 0), C::count);
+  frameEnd();
+}
+
+// Alternating Solid Color Strip Halves (half of strip color1, other half color2)
+template <class C>
+void emergency(const Pattern &p, PatternState &s) {
+  uint16_t half = C::count/2;
+  bool swap = !(s.steps & 1);               //  Swaps every step
+  frameBegin();
+  frameRun(wire(p.color[swap ? 1 : 0]), half);
+  frameRun(wire(p.color[swap ? 0 : 1]), C::count - half);
+  frameEnd();
+}
+
+// Alternating Solid Color Bands... choose width of the bands
+template <class C>
+void alternatingBands(const Pattern &p, PatternState &s) {
+  bool swap = !(s.steps & 1);               //  Swaps every step
+  const uint32_t colors[2] = {p.color[swap ? 1 : 0], p.color[swap ? 0 : 1]};
+  periodicPalette<C>(colors, 2, p.width, 0);
+}
+
+#ifdef NOISEEFFECTS
+// Fire: value noise scrolling up the strip from the first led, cooling towards the far end, through a black body palette.
+// A step moves the flames 1/8 of a noise cell.
+template <class C>
+void fire(const Pattern &p, PatternState &s) {
+  constexpr uint16_t cool = (192UL << 8) / C::count;   //  heat lost per led (8.8), the far end keeps a quarter
+  uint16_t rise = s.steps << 5;
+  uint16_t flicker = s.steps << 3;
+  uint16_t lost = 0;                                      //  i * cool, kept as a running sum (no multiply per led)
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++, lost += cool) {
+    uint8_t heat = scale8(noise8((i << 6) - rise, flicker), 255 - (uint8_t)(lost >> 8));
+    uint8_t r = heat < 85 ? heat * 3 : 255;                         //  black, red, yellow, white
+    uint8_t g = heat < 85 ? 0 : heat < 170 ? (heat - 85) * 3 : 255;
+    uint8_t b = heat < 170 ? 0 : (heat - 170) * 3;
+    frameRun(wire(rgb(r, g, b)), 1);
   }
-  else  {
-    pixelCycle = 1;
-    for(uint16_t i=0; i < pixelNumber; i++) {
-      strip.setPixelColor(i, color);
-    }
+  frameEnd();
+}
+
+// Plasma: Wheel() colors from 2D noise over the strip and time. 'width' is the detail: 1/16ths of a noise cell per led.
+template <class C>
+void plasma(const Pattern &p, PatternState &s) {
+  uint16_t scale = p.width << 4;
+  uint16_t time = s.steps << 2;
+  uint8_t  hue = s.steps >> 2;              //  the whole palette drifts slowly too
+  uint16_t x = 0;                           //  i * scale, as a running sum
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++, x += scale) {
+    frameRun(wire(Wheel(noise8(x, time) + hue)), 1);
   }
-  strip.show();
-  return;
+  frameEnd();
 }
 
-// Alternating Solid Color Strip Halves (half of strip color1, other half color2)
-void emergency(uint32_t color1,uint32_t color2, uint8_t wait) {
-  pixelInterval = wait;                   //  Update delay time
-  if(pixelCycle > 1) pixelCycle = 0;
-  if(pixelCycle)  {
-    pixelCycle = 0;
-    for(uint16_t i=0; i < pixelNumber/2; i++) {
-      strip.setPixelColor(i, color1);
+// Twinkling stars: every led fades in and out in color 1, each at its own phase and pace (hashed from its index).
+// A step is 1/256 of the slowest star's cycle.
+template <class C>
+void twinkle(const Pattern &p, PatternState &s) {
+  uint8_t r = p.color[0] >> 16, g = p.color[0] >> 8, b = p.color[0];
+  uint8_t step = s.steps;
+  const uint8_t paced[4] = {step, (uint8_t)(step << 1), (uint8_t)(step + (step << 1)), (uint8_t)(step << 2)};
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++) {
+    uint8_t pace = hash8(i + 0x8000) >> 6;                          //  1-4x, as paced[0-3]
+    uint8_t phase = hash8(i) + paced[pace];
+    uint8_t level = phase < 128 ? phase << 1 : (255 - phase) << 1;  //  triangle wave
+    level = scale8(level, level);                                   //  squared: short bright peaks, long dark gaps
+    frameRun(wire(rgb(scale8(r, level), scale8(g, level), scale8(b, level))), 1);
+  }
+  frameEnd();
+}
+
+// Sparkle: random leds flash color 1 for one frame over color 2, about 'width' per 256 leds per frame.
+// Unlit leds go out as runs, so a frame costs one xorshift per led plus a run per sparkle.
+template <class C>
+void sparkle(const Pattern &p, PatternState &s) {
+  uint16_t &seed = s.sparkle.seed;
+  if(!seed) {
+    seed = 0xACE1;                          //  any nonzero start
+  }
+  WirePixel spark = wire(p.color[0]), base = wire(p.color[1]);
+  uint16_t run = 0;
+  frameBegin();
+  for(uint16_t i=0; i < C::count; i++) {
+    if(random8(seed) < p.width) {
+      frameRun(base, run);
+      frameRun(spark, 1);
+      run = 0;
     }
-    for(uint16_t i=pixelNumber/2; i < pixelNumber; i++) {
-      strip.setPixelColor(i, color2);
+    else {
+      run++;
     }
   }
-  else  {
-    pixelCycle = 1;
-    for(uint16_t i=0; i < pixelNumber/2; i++) {
-      strip.setPixelColor(i, color2);
+  frameRun(base, run);
+  frameEnd();
+}
+#endif
+
+#ifdef USEMSP
+// Throttle gauge: lit from the first pixel in proportion to the throttle stick, color 1 on color 2 (USEMSP)
+template <class C>
+void throttleBar(const Pattern &p, PatternState &s) {
+  uint16_t lit = (uint32_t)C::count * telemetry.throttle / 255;
+  frameBegin();
+  frameRun(wire(p.color[0]), lit);
+  frameRun(wire(p.color[1]), C::count - lit);
+  frameEnd();
+}
+#endif
+
+// All leds off
+template <class C>
+void allOff(const Pattern &p, PatternState &s) {
+  frameBegin();
+  frameRun(wire(0), C::count);
+  frameEnd();
+}
+
+#ifdef PATTERNPROGRAMS
+// Per frame numbers of one draw op of a program (see programPlan())
+struct ProgramDraw {
+  uint16_t pixels;    // pixels the op draws
+  uint16_t run;       // OP_WIPE: pixels of the first color, OP_BANDS/OP_STRIPES: of the first band, OP_SPARSE: unlit ones first
+  uint8_t  first;     // OP_WIPE: 1 when wiping slot 0 back over the color, OP_BANDS/OP_STRIPES: slot of the first band
+};
+
+const uint8_t opArgs[OP_COUNT] PROGMEM = OP_ARGS;
+
+// Work out this frame's numbers for each draw op of a program: its pixel count, and where its wipe or bands are.
+// This runs before frameBegin(), so the multiplies, divides and modulos are never done between two streamed pixels
+// (see streamout.h). Returns the number of draw ops, at most PROGRAM_DRAWS (the program ends after that many).
+uint8_t programPlan(const uint8_t *pc, uint16_t count, uint32_t steps, ProgramDraw *plan) {
+  uint16_t done = 0;                        //  Pixels drawn so far
+  uint8_t  draws = 0;
+  for(;;) {
+    uint8_t op = pgm_read_byte(pc++);
+    if(op == OP_END || op >= OP_COUNT) {
+      return draws;
     }
-    for(uint16_t i=pixelNumber/2; i < pixelNumber; i++) {
-      strip.setPixelColor(i, color1);
+    uint8_t args = pgm_read_byte(&opArgs[op]);
+    if(op >= OP_FILL) {                     //  a draw op
+      if(draws == PROGRAM_DRAWS) {
+        return draws;
+      }
+      ProgramDraw &d = plan[draws++];
+      uint16_t rest = count - done;
+      d.pixels = rest;
+      d.run = 0;
+      d.first = 0;
+      switch(op) {
+        case OP_FILL:
+        case OP_PART: {
+          uint16_t n = op == OP_FILL ? pgm_read_word(pc + 1) : (uint32_t)count * pgm_read_byte(pc + 1) >> 8;
+          if(n && n < rest) {
+            d.pixels = n;
+          }
+          break;
+        }
+        case OP_WIPE:                       //  As colorWipe(), over the rest of the strip
+          if(rest) {
+            uint16_t position = steps % (2 * (uint32_t)rest);
+            d.first = position >= rest;
+            d.run = (d.first ? position - rest : position) + 1;
+          }
+          break;
+        case OP_BANDS:
+        case OP_STRIPES: {
+          uint8_t width = pgm_read_byte(pc), n = pgm_read_byte(pc + 1);
+          d.run = paletteStart(n, width, op == OP_BANDS ? steps % (n * width) : 0, d.first);
+          args += n;
+          break;
+        }
+        case OP_SPARSE:
+          d.run = steps % pgm_read_byte(pc);
+          break;
+      }
+      done += d.pixels;
     }
+    pc += args;
   }
-  strip.show();
-  return;
 }
 
-// Alternating Solid Color Bands... choose width of the bands
-void alternatingBands(uint32_t color1,uint32_t color2, uint8_t width, uint8_t wait) {
-  pixelInterval = wait;                   //  Update delay time
-  if(pixelCycle > 1) pixelCycle = 0;
-  if(pixelCycle)  {
-    pixelCycle = 0;
-    for(uint16_t i=0; i < pixelNumber; i=i) {
-      for(uint16_t j=0; j < width ; j++) {
-        if(i < pixelNumber) {
-          strip.setPixelColor(i, color1);
-          i++;
+// Run the pattern's bytecode program (see bytecode.h): one pass per frame, each op drawing on from the last.
+// The numbers are planned first, so between the pixels only the draw loops run, as in the renderers.
+template <class C>
+void program(const Pattern &p, PatternState &s) {
+  WirePixel       slots[PROGRAM_SLOTS];
+  WirePixel       wires[PALETTE_MAX];
+  ProgramDraw     plan[PROGRAM_DRAWS];
+  uint8_t         draws = programPlan(p.program, C::count, s.steps, plan);
+  const ProgramDraw *d = plan;              //  Plan of the next draw op
+  const uint8_t  *pc = p.program;
+  uint16_t        done = 0;                 //  Pixels drawn so far
+  uint8_t         hue = s.steps;            //  Wheel ops: a hue per step
+  slots[0] = wire(0);
+  frameBegin();
+  for(;;) {
+    uint8_t op = pgm_read_byte(pc++);
+    if(op >= OP_FILL && d == plan + draws) {
+      op = OP_END;                          //  past the planned draw ops (or a bad op)
+    }
+    switch(op) {
+      case OP_COLOR:
+        slots[pgm_read_byte(pc) & (PROGRAM_SLOTS - 1)] = wire(rgb(pgm_read_byte(pc + 1), pgm_read_byte(pc + 2), pgm_read_byte(pc + 3)));
+        pc += 4;
+        continue;
+      case OP_SWAP:
+        if(s.steps & 1) {
+          WirePixel &a = slots[pgm_read_byte(pc) & (PROGRAM_SLOTS - 1)];
+          WirePixel &b = slots[pgm_read_byte(pc + 1) & (PROGRAM_SLOTS - 1)];
+          WirePixel  t = a;
+          a = b;
+          b = t;
         }
+        pc += 2;
+        continue;
+      case OP_FILL:
+      case OP_PART:
+        frameRun(slots[pgm_read_byte(pc) & (PROGRAM_SLOTS - 1)], d->pixels);
+        pc += op == OP_FILL ? 3 : 2;
+        break;
+      case OP_WIPE: {
+        const WirePixel &on = slots[pgm_read_byte(pc++) & (PROGRAM_SLOTS - 1)];
+        frameRun(d->first ? slots[0] : on, d->run);
+        frameRun(d->first ? on : slots[0], d->pixels - d->run);
+        break;
       }
-      for(uint16_t j=0; j < width ; j++) {
-        if(i < pixelNumber) {
-          strip.setPixelColor(i, color2);
-          i++;
+      case OP_BANDS:
+      case OP_STRIPES: {
+        uint8_t width = pgm_read_byte(pc);
+        uint8_t count = pgm_read_byte(pc + 1);
+        pc += 2;
+        for(uint8_t c=0; c < count; c++) {
+          wires[c] = slots[pgm_read_byte(pc++) & (PROGRAM_SLOTS - 1)];
         }
+        paletteRun(wires, count, width, d->first, d->run, d->pixels);
+        break;
       }
-    }
-  }
-  else  {
-    pixelCycle = 1;
-    for(uint16_t i=0; i < pixelNumber; i=i) {
-      for(uint16_t j=0; j < width ; j++) {
-        if(i < pixelNumber) {
-          strip.setPixelColor(i, color2);
-          i++;
+      case OP_WHEEL: {                      //  As rainbow(), 'stride' hues per pixel
+        uint8_t stride = pgm_read_byte(pc++);
+        uint8_t h = hue;
+        for(uint16_t i=0; i < d->pixels; i++, h += stride) {
+          frameRun(wire(Wheel(h)), 1);
         }
+        break;
       }
-      for(uint16_t j=0; j < width ; j++) {
-        if(i < pixelNumber) {
-          strip.setPixelColor(i, color1);
-          i++;
+      case OP_RAINBOW:                      //  As rainbowFull(), from this pixel on
+        for(uint16_t i=done; i < C::count; i++) {
+          frameRun(wire(Wheel(pgm_read_byte(&rainbowTable.hue[i]) + hue)), 1);
+        }
+        break;
+      case OP_SPARSE: {                     //  As theaterChaseRainbow(), one lit pixel in 'gap'
+        uint8_t  gap = pgm_read_byte(pc++);
+        uint16_t rest = d->pixels;
+        uint16_t queue = d->run;
+        frameRun(slots[0], queue < rest ? queue : rest);
+        for(uint16_t i=0; i + queue < rest; i+=gap) {
+          uint16_t left = rest - i - queue - 1;
+          frameRun(wire(Wheel((i + hue) & 255)), 1);
+          frameRun(slots[0], left < gap - 1 ? left : gap - 1);
         }
+        break;
       }
+      default:                              //  OP_END (or a bad op): blank what is left and show
+        frameRun(slots[0], C::count - done);
+        frameEnd();
+        return;
     }
+    done += d++->pixels;
   }
-  strip.show();
-  return;
 }
+#endif
 
-// DON'T FORGET to add a case when adding a new pattern function!!!
+// Start a new pattern from its first step, with none of the last pattern's state
+void patternRestart(unsigned long now) {
+  memset(&patternState, 0, sizeof(patternState));
+  patternState.millis = now;
+  #if defined(STREAMOUTPUT) && defined(POWERBUDGET)
+    powerDim = powerStartDim;           //  the new pattern's load is not known yet, the old one's dim says nothing about it
+    powerNeededMillis = now;
+    levelBuild(levelBrightness);
+  #endif
+}
 
-void loop() {
-  currentMillis = millis();                     //  Update current time
-  
-  // Read toggle pin and update accordingly, every TOGGLETIME milliseconds
-  if(currentMillis - currentToggleMillis > TOGGLEDELAY ) {
-    currentToggleMillis = currentMillis;
-    toggleStatePrevious = toggleState;  // Save toggle pin then read new value
-    toggleState = digitalRead(TOGGLEPIN);
-    if(!toggleState) {    // toggle pin is low, turn off the strip
-      pattern = 1;
+// Advance the animation by the time since the last frame at the pattern's speed, so late or dropped frames
+// catch up instead of slowing the pattern down
+#define ANIMMAXSTEP 10000   // longest gap (millis) advanced in one go, keeps the fixed point product in 32 bits
+void animAdvance(PatternState &s, unsigned long now, uint32_t speed) {
+  unsigned long elapsed = now - s.millis;
+  s.millis = now;
+  if(elapsed > ANIMMAXSTEP) {
+    elapsed = ANIMMAXSTEP;
+  }
+  uint32_t total = (uint32_t)elapsed * (speed & 0xFFFF) + s.fraction;  //  Split so each product fits 32 bits
+  s.steps += (uint32_t)elapsed * (speed >> 16) + (total >> 16);
+  s.fraction = total;
+}
+
+// Render one frame of the current pattern: copy its table entry out of flash and call its renderer
+void renderPattern() {
+  INSTR_START(INSTR_RENDER);
+  PROF_ENTER(PROF_RENDER);
+  Pattern p;
+  if(pattern >= 1 && pattern <= TOTALPATTERNS) {
+    memcpy_P(&p, &patterns[pattern - 1], sizeof(p));
+  }
+  else {  // this should never happen...
+    memcpy_P(&p, &errorPattern, sizeof(p));
+  }
+  #ifdef USEMSP
+    if(mspLowBattery && pattern != 1) {  //  The warning shows unless the strip is toggled off
+      memcpy_P(&p, &lowBatteryPattern, sizeof(p));
     }
-    else if(!toggleStatePrevious) {  // toggle was pin released, reload the pattern saved in EEPROM
-      pattern = EEPROM.read(eepromAddress);
+  #endif
+  pixelInterval = p.interval;
+  animAdvance(patternState, currentMillis, p.speed);
+  p.render(p, patternState);
+  PROF_EXIT(PROF_RENDER);
+  INSTR_STOP(INSTR_RENDER);
+}
+
+#ifdef USEMSP
+// Apply the FC telemetry: the low battery warning, and the throttle brightness. Stale telemetry (FC not
+// answering) turns both off. The cell count is taken from the first voltage, when the pack is still full.
+#define MSPCELLMAX 430    // 1/100 V of a full cell
+#define MSPCELLHYST 10    // 1/100 V per cell the voltage must recover by to end the warning (sag under load)
+void mspBind(unsigned long now) {
+  bool fresh = mspFresh(now);
+  if(fresh && telemetry.voltage && !mspCells) {
+    mspCells = (telemetry.voltage + MSPCELLMAX - 1) / MSPCELLMAX;
+  }
+  if(!fresh || !telemetry.voltage) {
+    mspLowBattery = false;
+  }
+  else if(telemetry.voltage < mspCells * MSPLOWCELL) {
+    mspLowBattery = true;
+  }
+  else if(telemetry.voltage >= mspCells * (MSPLOWCELL + MSPCELLHYST)) {
+    mspLowBattery = false;
+  }
+  #ifdef MSPTHROTTLEBRIGHT
+    uint8_t scale = 255;
+    if(fresh && telemetry.armed) {                        //  16 steps, so the level table is rebuilt at most 16 times a sweep
+      scale = MSPTHROTTLEFLOOR + (uint16_t)(255 - MSPTHROTTLEFLOOR) * (telemetry.throttle >> 4) / 15;
     }
-    else  return;
-  }
-
-  // Read inputs and update pattern  every MODEDELAY milliseconds
-  if(currentMillis - currentModeMillis > MODEDELAY ) {
-    currentModeMillis = currentMillis;    // reset timer
-    modeStatePrevious = modeState;    // save previous mode pin state
-    modeState = digitalRead(MODEPIN);
-    if(!modeState) {    // mode pin is low
-      pattern++;
-      if(pattern > TOTALPATTERNS) {   // repeat cycling through patterns, including off (in case toggle is not used)
-        pattern = 1;
-      }
+    uint8_t brightness = (uint16_t)settings.brightness * (scale + 1) >> 8;
+    if(brightness != levelBrightness) {
+      levelBuild(brightness);
     }
-    if(modeState && !modeStatePrevious && pattern != EEPROM.read(eepromAddress)) { // mode pin is released, and the selected pattern is different than the one stored in EEPROM... save the new pattern
-      eepromAddress++;  // increment eeprom for wear leveling
-      if (eepromAddress == EEPROM.length()) { // check for overflow address, reset to address 0 if true
-        eepromAddress = 0;
-      }
-      EEPROM.write(eepromAddress-1, 0); // write 0 to old eeprom address, then write to the new address
-      EEPROM.write(eepromAddress,pattern);  // no need for a delay here to prevent eeprom wear, since MODEDELAY repeats slow enough to debounce a button
+  #endif
+}
+#endif
+
+// The next dimmer level in BRIGHTLEVELS, back to the brightest after the dimmest
+uint8_t nextBrightness(uint8_t brightness) {
+  for(uint8_t i=0; i < sizeof(brightLevels); i++) {
+    uint8_t level = pgm_read_byte(&brightLevels[i]);
+    if(level < brightness) {
+      return level;
     }
   }
+  return pgm_read_byte(&brightLevels[0]);
+}
 
+#ifdef RCINPUT
+#if RCINPUT == RC_BRIGHTNESS
+extern const uint8_t  rcBands = sizeof(brightLevels);   // one band per brightness level, low stick is dim
+#else
+extern const uint8_t  rcBands = TOTALPATTERNS;          // one band per pattern
+#endif
+extern const uint16_t rcLow = RCLOW, rcHigh = RCHIGH;   // visible to host/rcsweep.cpp
+extern const uint8_t  rcPin = RCPIN;
 
-  // Update pixels when ready
-  if(currentMillis - pixelPrevious >= pixelInterval) {        //  Check for expired time
-    pixelPrevious = currentMillis;                            //  Run current frame
-    switch(pattern) {                                   
-      // Some patterns take the format:
-      // [strip.Color(red, green, blue), ..., millis between frames].
-      // Change colors of these patterns by editing the color numbers to any value between 0-255.
-      // See this page to get color codes: https://www.google.com/search?q=rgb+color+picker
-      // The last number is milliseconds between frames. Edit this number to change a pattern's speed (lower is faster).
-      // Some patterns have additional inputs (info on these inputs is found in the comments)
-      // You can copy/paste/modify patterns to make variations, or create custom pattern functions as you wish.
-      // Just remember to increment the TOTALPATTERNS definition at the top, and add a switch case below so you can access them.
-      
-      default: { // this case should never happen...
-        flashingColor(strip.Color(255, 0, 0), 10);  // fast flashing solid red ERROR!!!
-        break;
-      }
-      case 1: { // all off
-        strip.clear();
-        strip.show();
-        break;
-      }
-      case 2: { // default pattern (on first boot usually... also later boots if no mode changes are saved)
-        rainbowFull(1);  // same as rainbow, but all colors shown at once
-        break;
-      }
-      case 3: { // Red white and blue
-        theaterChaseTricolor(strip.Color(255, 0, 0),strip.Color(255, 255, 255),strip.Color(0, 0, 255), 50);
-        break;
-      }
-      case 4: { // Rainbow incrementing one color per led (256 colors)
-        rainbow(5);
-        break;     
-      }
-      case 5: { // Rainbow-enhanced theaterChase variant
-        theaterChaseRainbow(50);
-        break;
-      }
-      case 6: { // Green wipe
-        colorWipe(strip.Color(0, 255, 0), 10);
-        break;        
-      }
-      case 7: { // Red white and blue clusters
-        theaterChaseTricolorSpaces(strip.Color(255, 0, 0),strip.Color(255, 255, 255),strip.Color(0, 0, 255), 25);
-        break;
-      }
-      case 8: { // solid green
-        solidColor(strip.Color(255, 255, 255)); 
-        break;
-      }
-      case 9: { // flashing solid green
-        flashingColor(strip.Color(255, 255, 255), 200); 
-        break;
+// Band of an RC pulse width: RCLOW to RCHIGH split evenly into 'bands', wider or narrower pulses in the end bands
+uint8_t rcBand(uint16_t width, uint8_t bands) {
+  if(width <= RCLOW) return 0;
+  if(width >= RCHIGH) return bands - 1;
+  return (uint32_t)(width - RCLOW) * bands / (RCHIGH - RCLOW + 1);
+}
+
+// Select the pattern (or brightness level) of an RC pulse. It shows right away, and is saved once it has been
+// held for RCSETTLEDELAY. A selection needs two pulses in a row in the same band, RCHYSTERESIS inside it.
+void rcSelect(unsigned long now) {
+  uint16_t width;
+  if(pulseRead(width)) {
+    uint8_t band = rcBand(width - RCHYSTERESIS, rcBands);
+    if(band != rcBand(width + RCHYSTERESIS, rcBands)) {
+      band = 0xFF;                              //  on a band edge, keep what is selected
+    }
+    if(band != 0xFF && band == rcBandSeen && band != rcBandSelected) {
+      rcBandSelected = band;
+      rcSelectMillis = now;
+      #if RCINPUT == RC_BRIGHTNESS
+        uint8_t level = pgm_read_byte(&brightLevels[rcBands - 1 - band]);
+        rcUnsaved = level != settings.brightness;
+        settings.brightness = level;            //  (saved below, or with the next save of the pattern)
+        levelBuild(level);
+      #else
+        rcUnsaved = band + 1 != settings.pattern;
+        settings.pattern = band + 1;
+        if(!inputPressed(toggleInput)) {        //  a toggled off strip stays off
+          pattern = band + 1;
+        }
+      #endif
+    }
+    rcBandSeen = band;
+  }
+  if(rcUnsaved && now - rcSelectMillis >= RCSETTLEDELAY) {
+    settingsSave(settings);
+    rcUnsaved = false;
+  }
+}
+#endif
+
+void loop() {
+  PROF_ENTER(PROF_LOOP);
+  currentMillis = clockMillis();                //  Update current time (corrected for show() blackouts)
+  INSTR_START(INSTR_INPUT);
+
+  // Toggle pin low turns the strip off, high restores the saved pattern.
+  // A quick off/on tap (shorter than BRIGHTTAPDELAY) also steps to the next brightness level and saves it.
+  switch(inputUpdate(toggleInput, currentMillis)) {
+    case INPUT_PRESS:
+      pattern = 1;
+      toggleMillis = currentMillis;
+      break;
+    case INPUT_RELEASE:
+      pattern = settings.pattern;
+      if(currentMillis >= MODESTARTDELAY && currentMillis - toggleMillis < BRIGHTTAPDELAY) {
+        settings.brightness = nextBrightness(settings.brightness);
+        settingsSave(settings);
+        levelBuild(settings.brightness);
       }
-      case 10: { // Red theater chase
-        theaterChase(strip.Color(255, 0, 0), 50);
+      break;
+    default:
+      break;
+  }
+
+  // Mode pin low steps to the next pattern right away, then every MODEDELAY while it stays low.
+  // Releasing it locks the pattern, and saves it if it changed. Ignored while the strip is toggled off.
+  // RCINPUT: the pulse width on the pin selects the pattern (or brightness) instead.
+  #ifdef RCINPUT
+    rcSelect(currentMillis);
+  #else
+  if(currentMillis >= MODESTARTDELAY && !inputPressed(toggleInput)) {
+    switch(inputUpdate(modeInput, currentMillis)) {
+      case INPUT_PRESS:
+      case INPUT_HOLD:
+        pattern++;
+        if(pattern > TOTALPATTERNS) {   // repeat cycling through patterns, including off (in case toggle is not used)
+          pattern = 1;
+        }
         break;
-      }
-      case 11: { // alternating halves, red and blue
-        emergency(strip.Color(255, 0, 0),strip.Color(0, 0, 255), 100); 
+      case INPUT_RELEASE:
+        if(pattern != settings.pattern) {
+          settings.pattern = pattern;
+          settingsSave(settings);
+        }
         break;
-      }
-      case 12: { // alternating yellow & blue 10 pixel wide bands, 100msec frame period
-        alternatingBands(strip.Color(245, 200, 66),strip.Color(0, 0, 255), 10, 100); 
+      default:
         break;
+    }
+  }
+  #endif
+
+  #ifdef USEMSP
+    mspPoll(currentMillis);                     //  Telemetry from the FC, only what has arrived (never waits)
+    mspBind(currentMillis);
+  #endif
+  INSTR_STOP(INSTR_INPUT);
+
+  // Update pixels when ready
+  if(pattern != patternRendered) {                            //  A new pattern renders right away, from its first step
+    frameRestart(currentMillis);
+    patternRestart(currentMillis);
+    #ifdef TRANSITION
+      if(patternRendered) {                                   //  and fades in over the last frame (not on the first one)
+        transitionStart(currentMillis);
       }
-      case 13: { // theater chase, 3 color bands, adjustable width (sacmob Y P G)
-        theaterChaseTricolorWidth(strip.Color(168, 117, 0),strip.Color(255, 14, 89),strip.Color(43, 198, 57),3,20);
-        break;
+    #endif
+  }
+  if(frameDue(currentMillis)) {                               //  Check for expired time
+    patternRendered = pattern;                                //  Run current frame
+    renderPattern();
+    unsigned long interval = pixelInterval;
+    #ifdef TRANSITION
+      if(transitionActive && interval > TRANSITIONFRAME) {    //  Keep a transition smooth, even into a slow pattern
+        interval = TRANSITIONFRAME;
       }
-    } // DON'T FORGET to increment TOTALPATTERNS definition when adding a new pattern case!!!
+    #endif
+    frameDone(clockMillis(), interval);
+    INSTR_FRAME(patternRendered);
   }
+  INSTR_POLL(currentMillis);
+  PROF_EXIT(PROF_LOOP);
 }
 
@@ -0,0 +1,184 @@
+// MSP telemetry client, see msp.h
+#include <Arduino.h>
+#include "msp.h"
+
+#if !defined(__AVR__)
+  #include <fcntl.h>
+  #include <stdlib.h>
+  #include <termios.h>
+  #include <unistd.h>
+#endif
+
+MspTelemetry telemetry;
+
+enum MspState : uint8_t { MSP_IDLE, MSP_M, MSP_DIRECTION, MSP_SIZE, MSP_COMMAND, MSP_PAYLOAD, MSP_CHECKSUM };
+
+static const uint8_t mspPolls[] = {MSP_RC, MSP_STATUS, MSP_RC, MSP_ANALOG};
+
+static MspState      mspState = MSP_IDLE;
+static bool          mspError = false;          // reply is '!' (command not supported)
+static uint8_t       mspSize, mspCommand, mspCount, mspSum;
+static uint8_t       mspPayload[MSP_PAYLOAD_MAX];
+static uint8_t       mspNext = 0;               // index in mspPolls[] of the next request
+static unsigned long mspSent = 0;               // millis the last request went out
+static bool          mspAnswered = false;       // a good reply has arrived
+
+// PORT ////////////////////////////////////////////////
+
+#if defined(__AVR_ATmega32U4__)
+  #define MSP_SERIAL Serial1
+#elif defined(__AVR__)
+  #define MSP_SERIAL Serial
+#endif
+
+#ifdef MSP_SERIAL
+static void mspOpen() {
+  MSP_SERIAL.begin(MSP_BAUD);
+}
+
+static int mspRead() {
+  return MSP_SERIAL.read();
+}
+
+// Write a whole frame, or nothing if the transmit buffer can't take it without waiting
+static void mspWrite(const uint8_t *frame, uint8_t size) {
+  if(MSP_SERIAL.availableForWrite() >= size) {
+    MSP_SERIAL.write(frame, size);
+  }
+}
+#else
+static int mspPort = -1;
+
+static void mspOpen() {
+  const char *path = getenv("MSP_PORT");
+  if(!path) return;
+  mspPort = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(mspPort >= 0) {
+    struct termios tio;
+    if(tcgetattr(mspPort, &tio) == 0) {
+      cfmakeraw(&tio);
+      tcsetattr(mspPort, TCSANOW, &tio);
+    }
+  }
+}
+
+static int mspRead() {
+  uint8_t c;
+  return mspPort >= 0 && read(mspPort, &c, 1) == 1 ? c : -1;
+}
+
+static void mspWrite(const uint8_t *frame, uint8_t size) {
+  if(mspPort >= 0 && write(mspPort, frame, size) < 0) {
+    return;   // a full pty drops the request, like a full UART buffer
+  }
+}
+#endif
+
+// PARSER ////////////////////////////////////////////////
+
+static uint16_t mspWord(uint8_t at) {
+  return mspPayload[at] | (uint16_t)mspPayload[at + 1] << 8;
+}
+
+// Take the fields we use out of a good reply
+static void mspReply(unsigned long now) {
+  switch(mspCommand) {
+    case MSP_STATUS:             // cycleTime, i2cErrors, sensors (u16 each), flight mode flags (u32), ...
+      if(mspSize < 10) return;
+      telemetry.modes = mspWord(6) | (uint32_t)mspWord(8) << 16;
+      telemetry.armed = telemetry.modes & 1;
+      break;
+    case MSP_RC: {               // u16 per channel, in microseconds
+      if(mspSize < MSP_THROTTLE * 2 + 2) return;
+      uint16_t us = mspWord(MSP_THROTTLE * 2);
+      telemetry.throttle = us <= 1000 ? 0 : us >= 2000 ? 255 : (uint32_t)(us - 1000) * 255 / 1000;
+      break;
+    }
+    case MSP_ANALOG:             // vbat (1/10 V, u8), mAh, rssi, amps (u16 each), then vbat in 1/100 V (Betaflight 4+)
+      if(mspSize < 1) return;
+      telemetry.voltage = mspSize >= 9 ? mspWord(7) : mspPayload[0] * 10;
+      break;
+    default:
+      return;
+  }
+  telemetry.millis = now;
+  mspAnswered = true;
+}
+
+// Run one received byte through the frame state machine: $ M > size command payload checksum
+static void mspParse(uint8_t c, unsigned long now) {
+  switch(mspState) {
+    case MSP_IDLE:
+      mspState = c == '$' ? MSP_M : MSP_IDLE;
+      break;
+    case MSP_M:
+      mspState = c == 'M' ? MSP_DIRECTION : MSP_IDLE;
+      break;
+    case MSP_DIRECTION:
+      mspError = c == '!';
+      mspState = c == '>' || c == '!' ? MSP_SIZE : MSP_IDLE;
+      break;
+    case MSP_SIZE:
+      mspSize = c;
+      mspSum = c;
+      mspCount = 0;
+      mspState = MSP_COMMAND;
+      break;
+    case MSP_COMMAND:
+      mspCommand = c;
+      mspSum ^= c;
+      mspState = mspSize ? MSP_PAYLOAD : MSP_CHECKSUM;
+      break;
+    case MSP_PAYLOAD:
+      if(mspCount < MSP_PAYLOAD_MAX) {
+        mspPayload[mspCount] = c;
+      }
+      mspSum ^= c;
+      if(++mspCount == mspSize) {
+        mspState = MSP_CHECKSUM;
+      }
+      break;
+    case MSP_CHECKSUM:
+      if(c == mspSum && !mspError) {
+        if(mspSize > MSP_PAYLOAD_MAX) {
+          mspSize = MSP_PAYLOAD_MAX;    // only the bytes kept count
+        }
+        mspReply(now);
+      }
+      mspState = MSP_IDLE;
+      break;
+  }
+}
+
+// CLIENT ////////////////////////////////////////////////
+
+uint8_t mspRequest(uint8_t cmd, uint8_t *frame) {
+  frame[0] = '$';
+  frame[1] = 'M';
+  frame[2] = '<';
+  frame[3] = 0;          // no payload
+  frame[4] = cmd;
+  frame[5] = 0 ^ cmd;    // checksum: xor of size, command and payload
+  return 6;
+}
+
+void mspBegin() {
+  mspOpen();
+}
+
+void mspPoll(unsigned long now) {
+  int c;
+  while((c = mspRead()) >= 0) {   // at most what the receive buffer holds (64 bytes), no waiting
+    mspParse(c, now);
+  }
+  if(now - mspSent >= MSP_POLLMS) {
+    uint8_t frame[6];
+    mspWrite(frame, mspRequest(mspPolls[mspNext], frame));
+    mspNext = (mspNext + 1) % sizeof(mspPolls);
+    mspSent = now;
+  }
+}
+
+bool mspFresh(unsigned long now) {
+  return mspAnswered && now - telemetry.millis < MSP_TIMEOUT;
+}
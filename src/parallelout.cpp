@@ -0,0 +1,126 @@
+// Bit-parallel WS2812 output, see parallelout.h.
+#include <Arduino.h>
+#include "parallelout.h"
+
+#define PARALLEL_LATCH_US   300   // low time between frames that latches WS2812B (v5) and older parts
+#define PARALLEL_BIT_CYCLES 22    // cycles per bit in the loop below
+#define PARALLEL_GAP_CYCLES 48    // about what loading the next bytes takes, between bytes
+
+static uint8_t  parallelStrips = 0;                 // strips in use
+static uint16_t parallelStart[PARALLEL_MAX];        // first byte of each strip in the frame buffer
+static uint16_t parallelBytes[PARALLEL_MAX];        // bytes sent to each strip
+static uint16_t parallelLongest = 0;                // bytes sent to the longest strip
+static unsigned long parallelEndMicros = 0;
+
+#ifdef __AVR__
+
+static volatile uint8_t *parallelPort;
+static uint8_t           parallelMask[PARALLEL_MAX];  // port bit of each strip
+static uint8_t           parallelAll = 0;              // port bits of all strips
+
+void parallelBegin(const ParallelStrip *strips, uint8_t count) {
+  uint16_t start = 0;
+  parallelPort = portOutputRegister(digitalPinToPort(strips[0].pin));
+  for(uint8_t i = 0; i < count; i++) {
+    uint16_t bytes = strips[i].count * 3;
+    if(parallelStrips < PARALLEL_MAX && portOutputRegister(digitalPinToPort(strips[i].pin)) == parallelPort) {
+      pinMode(strips[i].pin, OUTPUT);
+      digitalWrite(strips[i].pin, LOW);
+      parallelMask[parallelStrips] = digitalPinToBitMask(strips[i].pin);
+      parallelAll |= parallelMask[parallelStrips];
+      parallelStart[parallelStrips] = start;
+      parallelBytes[parallelStrips] = bytes;
+      if(bytes > parallelLongest) parallelLongest = bytes;
+      parallelStrips++;
+    }
+    start += bytes;
+  }
+  for(uint8_t i = parallelStrips; i < PARALLEL_MAX; i++) {   // unused strips send nothing
+    parallelMask[i] = 0;
+    parallelStart[i] = 0;
+    parallelBytes[i] = 0;
+  }
+}
+
+// 800KHz, 16-16.5MHz clock: 22 inst. clocks per bit: HHHHHHxxxxxxxLLLLLLLLL
+// ST instructions:                                   ^     ^      ^          (T=0,6,13)
+void parallelShow(const uint8_t *pixels) {
+  while(micros() - parallelEndMicros < PARALLEL_LATCH_US);
+  volatile uint8_t *port = parallelPort;
+  const uint8_t    *p0 = pixels + parallelStart[0], *p1 = pixels + parallelStart[1];
+  const uint8_t    *p2 = pixels + parallelStart[2], *p3 = pixels + parallelStart[3];
+  uint8_t           m0 = parallelMask[0], m1 = parallelMask[1], m2 = parallelMask[2], m3 = parallelMask[3];
+  noInterrupts();
+  uint8_t hi = *port | parallelAll, lo = *port & ~parallelAll;
+  for(uint16_t j = 0; j < parallelLongest; j++) {
+    uint8_t b0 = j < parallelBytes[0] ? p0[j] : 0;   // a finished strip sends zeros, they fall off its end
+    uint8_t b1 = j < parallelBytes[1] ? p1[j] : 0;
+    uint8_t b2 = j < parallelBytes[2] ? p2[j] : 0;
+    uint8_t b3 = j < parallelBytes[3] ? p3[j] : 0;
+    uint8_t next = lo;                                 // port value for the first bit
+    if(b0 & 0x80) next |= m0;
+    if(b1 & 0x80) next |= m1;
+    if(b2 & 0x80) next |= m2;
+    if(b3 & 0x80) next |= m3;
+    uint8_t bit = 8;
+
+    asm volatile(
+      "1:"                        "\n\t" // Clk  Pseudocode     (T =  0)
+      "st   %a[port], %[hi]"      "\n\t" // 2    PORT = hi      (T =  2)
+      "lsl  %[b0]"                "\n\t" // 1    b0 <<= 1       (T =  3)
+      "lsl  %[b1]"                "\n\t" // 1    b1 <<= 1       (T =  4)
+      "lsl  %[b2]"                "\n\t" // 1    b2 <<= 1       (T =  5)
+      "lsl  %[b3]"                "\n\t" // 1    b3 <<= 1       (T =  6)
+      "st   %a[port], %[next]"    "\n\t" // 2    PORT = next    (T =  8)
+      "mov  %[next], %[lo]"       "\n\t" // 1    next = lo      (T =  9)
+      "sbrc %[b0], 7"             "\n\t" // 1-2  if(b0 & 128)
+      "or   %[next], %[m0]"       "\n\t" // 0-1   next |= m0    (T = 11)
+      "sbrc %[b1], 7"             "\n\t" // 1-2  if(b1 & 128)
+      "or   %[next], %[m1]"       "\n\t" // 0-1   next |= m1    (T = 13)
+      "st   %a[port], %[lo]"      "\n\t" // 2    PORT = lo      (T = 15)
+      "sbrc %[b2], 7"             "\n\t" // 1-2  if(b2 & 128)
+      "or   %[next], %[m2]"       "\n\t" // 0-1   next |= m2    (T = 17)
+      "sbrc %[b3], 7"             "\n\t" // 1-2  if(b3 & 128)
+      "or   %[next], %[m3]"       "\n\t" // 0-1   next |= m3    (T = 19)
+      "dec  %[bit]"               "\n\t" // 1    bit--          (T = 20)
+      "brne 1b"                   "\n"   // 2    if(bit != 0) -> (next bit)
+      : [b0] "+r"(b0), [b1] "+r"(b1), [b2] "+r"(b2), [b3] "+r"(b3), [next] "+r"(next), [bit] "+r"(bit)
+      : [port] "e"(port), [hi] "r"(hi), [lo] "r"(lo), [m0] "r"(m0), [m1] "r"(m1), [m2] "r"(m2), [m3] "r"(m3));
+  }
+  interrupts();
+  parallelEndMicros = micros();
+}
+
+uint32_t parallelShowMicros() {
+  return (uint32_t)parallelLongest * (8 * PARALLEL_BIT_CYCLES + PARALLEL_GAP_CYCLES) / (F_CPU / 1000000UL);
+}
+
+#else  // host build: count frames
+
+unsigned long parallelFrames = 0;
+
+void parallelBegin(const ParallelStrip *strips, uint8_t count) {
+  uint16_t start = 0;
+  for(uint8_t i = 0; i < count; i++) {
+    uint16_t bytes = strips[i].count * 3;
+    if(parallelStrips < PARALLEL_MAX) {
+      parallelStart[parallelStrips] = start;
+      parallelBytes[parallelStrips] = bytes;
+      if(bytes > parallelLongest) parallelLongest = bytes;
+      parallelStrips++;
+    }
+    start += bytes;
+  }
+}
+
+void parallelShow(const uint8_t *pixels) {
+  (void)pixels;
+  parallelFrames++;
+  parallelEndMicros = micros();
+}
+
+uint32_t parallelShowMicros() {
+  return parallelLongest * 10UL;   // 8 bits at 800KHz per byte
+}
+
+#endif
@@ -0,0 +1,63 @@
+// Frame timing, see scheduler.h
+#include <Arduino.h>
+#include "scheduler.h"
+
+#ifdef __AVR__
+  #define CLOCK_TICK_US (64UL * 256 * 1000000UL / F_CPU)   // timer0 overflow period used by millis() (prescaler 64)
+#endif
+
+uint16_t frameSkips = 0;
+
+static unsigned long clockLostMillis = 0;   // whole millis added back
+#ifdef CLOCK_TICK_US
+static uint16_t      clockLostMicros = 0;   // and the remainder
+#endif
+static unsigned long frameDeadline = 0;
+
+unsigned long clockMillis() {
+  return millis() + clockLostMillis;
+}
+
+unsigned long clockMicros() {
+#ifdef CLOCK_TICK_US
+  return micros() + clockLostMillis * 1000 + clockLostMicros;
+#else
+  return micros() + clockLostMillis * 1000;
+#endif
+}
+
+void clockBlackout(uint32_t us) {
+#ifdef CLOCK_TICK_US
+  if(us <= CLOCK_TICK_US) {   // the one pending overflow is still serviced
+    return;
+  }
+  us -= CLOCK_TICK_US;
+  while(us >= 1000) {
+    clockLostMillis++;
+    us -= 1000;
+  }
+  clockLostMicros += us;
+  if(clockLostMicros >= 1000) {
+    clockLostMillis++;
+    clockLostMicros -= 1000;
+  }
+#else
+  (void)us;                   // the host clock does not lose ticks
+#endif
+}
+
+bool frameDue(unsigned long now) {
+  return (long)(now - frameDeadline) >= 0;
+}
+
+void frameDone(unsigned long now, unsigned long interval) {
+  frameDeadline += interval;
+  if((long)(now - frameDeadline) >= 0) {   // overran: drop the missed frames instead of bursting
+    frameSkips++;
+    frameDeadline = now + interval;
+  }
+}
+
+void frameRestart(unsigned long now) {
+  frameDeadline = now;
+}
@@ -0,0 +1,49 @@
+// EEPROM settings log, see settings.h
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "settings.h"
+
+static int settingsSlot = -1;   // slot holding the newest record (-1: none yet)
+
+static uint16_t settingsSlots() {
+  return EEPROM.length() / SETTINGS_RECORD_SIZE;
+}
+
+static void settingsRead(uint16_t slot, SettingsRecord &rec) {
+  uint8_t *p = (uint8_t *)&rec;
+  for(uint8_t i = 0; i < SETTINGS_RECORD_SIZE; i++) {
+    p[i] = EEPROM.read(slot * SETTINGS_RECORD_SIZE + i);
+  }
+}
+
+bool settingsLoad(SettingsRecord &rec) {
+  SettingsRecord slot, latest;
+  settingsSlot = -1;
+  for(uint16_t i = 0; i < settingsSlots(); i++) {
+    settingsRead(i, slot);
+    if(settingsValid(&slot) && (settingsSlot < 0 || settingsNewer(&slot, &latest))) {
+      latest = slot;
+      settingsSlot = i;
+    }
+  }
+  if(settingsSlot < 0) {
+    return false;
+  }
+  rec = latest;
+  return true;
+}
+
+void settingsSave(SettingsRecord &rec) {
+  uint16_t slot = settingsSlot < 0 ? 0 : settingsSlot + 1;
+  if(slot >= settingsSlots()) {
+    slot = 0;
+  }
+  rec.magic = SETTINGS_MAGIC;
+  rec.seq = settingsSlot < 0 ? 0 : rec.seq + 1;
+  rec.crc = settingsCrc(&rec);
+  const uint8_t *p = (const uint8_t *)&rec;
+  for(uint8_t i = 0; i < SETTINGS_RECORD_SIZE; i++) {
+    EEPROM.update(slot * SETTINGS_RECORD_SIZE + i, p[i]);   // crc goes last, so a cut short save never validates
+  }
+  settingsSlot = slot;
+}
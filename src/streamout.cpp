@@ -0,0 +1,92 @@
+// Bufferless WS2812 output, see streamout.h.
+// The AVR bit loop is the Adafruit_NeoPixel 16MHz "generic port" loop, run for a single pixel per call.
+// Its labels are local (1:, 2:), as the library's own head20/nextbyte20 are global and streamPixel() may be
+// inlined into several callers. Its locals are plain registers: the library's are volatile, which would put them
+// in a stack frame and load and store them on every call, while the line sits low between two pixels. The pixel
+// pointer is an output operand, as the loop advances it.
+#include <Arduino.h>
+#include "streamout.h"
+
+#define STREAM_LATCH_US 300   // low time between frames that latches WS2812B (v5) and older parts
+
+static unsigned long streamEndMicros = 0;
+
+#ifdef __AVR__
+
+static volatile uint8_t *streamPort;
+static uint8_t           streamHi, streamLo;
+
+void streamBegin(uint8_t pin) {
+  while(micros() - streamEndMicros < STREAM_LATCH_US);
+  streamPort = portOutputRegister(digitalPinToPort(pin));
+  uint8_t mask = digitalPinToBitMask(pin);
+  noInterrupts();
+  streamHi = *streamPort | mask;
+  streamLo = *streamPort & ~mask;
+}
+
+// 800KHz, 16-16.5MHz clock: 20 inst. clocks per bit: HHHHHxxxxxxxxLLLLLLL
+// ST instructions:                                   ^   ^        ^       (T=0,5,13)
+void streamPixel(const WirePixel &px) {
+  uint16_t                i = 3;
+  const uint8_t          *ptr = px.b;
+  uint8_t                 b = *ptr++, next = streamLo, bit = 8;
+  volatile uint8_t       *port = streamPort;
+  uint8_t                 hi = streamHi, lo = streamLo;
+
+  asm volatile(
+    "1:"                        "\n\t" // Clk  Pseudocode    (T =  0)
+    "st   %a[port],  %[hi]"     "\n\t" // 2    PORT = hi     (T =  2)
+    "sbrc %[byte],  7"          "\n\t" // 1-2  if(b & 128)
+    "mov  %[next], %[hi]"       "\n\t" // 0-1   next = hi    (T =  4)
+    "dec  %[bit]"               "\n\t" // 1    bit--         (T =  5)
+    "st   %a[port],  %[next]"   "\n\t" // 2    PORT = next   (T =  7)
+    "mov  %[next] ,  %[lo]"     "\n\t" // 1    next = lo     (T =  8)
+    "breq 2f"                   "\n\t" // 1-2  if(bit == 0) (from dec above)
+    "rol  %[byte]"              "\n\t" // 1    b <<= 1       (T = 10)
+    "rjmp .+0"                  "\n\t" // 2    nop nop       (T = 12)
+    "nop"                       "\n\t" // 1    nop           (T = 13)
+    "st   %a[port],  %[lo]"     "\n\t" // 2    PORT = lo     (T = 15)
+    "nop"                       "\n\t" // 1    nop           (T = 16)
+    "rjmp .+0"                  "\n\t" // 2    nop nop       (T = 18)
+    "rjmp 1b"                   "\n\t" // 2    -> 1 (next bit out)
+    "2:"                        "\n\t" //                    (T = 10)
+    "ldi  %[bit]  ,  8"         "\n\t" // 1    bit = 8       (T = 11)
+    "ld   %[byte] ,  %a[ptr]+"  "\n\t" // 2    b = *ptr++    (T = 13)
+    "st   %a[port], %[lo]"      "\n\t" // 2    PORT = lo     (T = 15)
+    "nop"                       "\n\t" // 1    nop           (T = 16)
+    "sbiw %[count], 1"          "\n\t" // 2    i--           (T = 18)
+    "brne 1b"                   "\n"   // 2    if(i != 0) -> (next byte)
+    : [port] "+e"(port), [byte] "+r"(b), [bit] "+r"(bit), [next] "+r"(next), [count] "+w"(i), [ptr] "+e"(ptr)
+    : [hi] "r"(hi), [lo] "r"(lo));
+}
+
+void streamEnd() {
+  interrupts();
+  streamEndMicros = micros();
+}
+
+#else  // host build: record what would have been sent
+
+uint8_t      *streamCapture = nullptr;
+unsigned long streamFrames = 0;
+static uint16_t streamIndex = 0;
+
+void streamBegin(uint8_t pin) {
+  (void)pin;
+  streamIndex = 0;
+}
+
+void streamPixel(const WirePixel &px) {
+  if(streamCapture) {
+    memcpy(streamCapture + streamIndex * 3, px.b, 3);
+  }
+  streamIndex++;
+}
+
+void streamEnd() {
+  streamFrames++;
+  streamEndMicros = micros();
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Packed (SWAR) transition blend of include/blend.h against the scalar mix: pio test -e native-test
+#include <unity.h>
+#include "blend.h"
+
+// Reference: from + (to - from) * mix / 128, rounded down
+static uint8_t mixScalar(uint8_t from, uint8_t to, uint8_t mix) {
+  return from + (((int)to - from) * mix >> 7);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Every byte pair at every mix amount, in both lanes of blendLanes()
+void test_lanes_match_scalar_mix() {
+  unsigned long wrong = 0;
+  for(uint16_t mix = 0; mix <= BLEND_MAX; mix++) {
+    for(uint16_t from = 0; from < 256; from++) {
+      for(uint16_t to = 0; to < 256; to++) {
+        uint32_t out = blendLanes(from | (uint32_t)(255 - from) << 16, to | (uint32_t)(255 - to) << 16, mix);
+        wrong += (out & 0xFFFF) != mixScalar(from, to, mix);
+        wrong += (out >> 16) != mixScalar(255 - from, 255 - to, mix);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, wrong);
+}
+
+// Every byte pair at every mix amount in each of the four bytes of blend4(), with different pairs in
+// the other bytes, so a carry from one channel into the next shows up
+void test_blend4_matches_scalar_mix_in_every_byte() {
+  unsigned long wrong = 0;
+  for(uint16_t mix = 0; mix <= BLEND_MAX; mix++) {
+    for(uint16_t from = 0; from < 256; from++) {
+      for(uint16_t to = 0; to < 256; to++) {
+        uint8_t f[4] = {(uint8_t)from, (uint8_t)to, (uint8_t)(255 - from), (uint8_t)(from ^ 0x5A)};
+        uint8_t t[4] = {(uint8_t)to, (uint8_t)from, (uint8_t)(255 - to), (uint8_t)(to ^ 0xA5)};
+        uint32_t a = 0, b = 0;
+        for(uint8_t i = 0; i < 4; i++) {
+          a |= (uint32_t)f[i] << (i * 8);
+          b |= (uint32_t)t[i] << (i * 8);
+        }
+        uint32_t out = blend4(a, b, mix);
+        for(uint8_t i = 0; i < 4; i++) {
+          wrong += (uint8_t)(out >> (i * 8)) != mixScalar(f[i], t[i], mix);
+        }
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, wrong);
+}
+
+// The per byte blend used where there is no hardware multiplier (BLEND_SWAR 0)
+void test_blend1_matches_scalar_mix() {
+  unsigned long wrong = 0;
+  for(uint16_t mix = 0; mix <= BLEND_MAX; mix++) {
+    for(uint16_t from = 0; from < 256; from++) {
+      for(uint16_t to = 0; to < 256; to++) {
+        wrong += blend1(from, to, mix) != mixScalar(from, to, mix);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, wrong);
+}
+
+// Whole buffers, including a tail that is not a multiple of four bytes, and the two ends of the mix
+void test_buffer_blend_and_ends() {
+  uint8_t from[23], to[23], expect[23];
+  for(uint8_t mix = 0; mix <= BLEND_MAX; mix += 16) {
+    for(uint8_t i = 0; i < sizeof(to); i++) {
+      from[i] = i * 37 + 11;
+      to[i] = 250 - i * 53;
+      expect[i] = mixScalar(from[i], to[i], mix);
+    }
+    blendBuffer(to, from, sizeof(to), mix);
+    for(uint8_t i = 0; i < sizeof(to); i++) {
+      TEST_ASSERT_EQUAL_UINT8(expect[i], to[i]);
+      if(mix == 0) {
+        TEST_ASSERT_EQUAL_UINT8(from[i], to[i]);                  // old frame only
+      }
+      if(mix == BLEND_MAX) {
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)(250 - i * 53), to[i]);  // new frame only
+      }
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lanes_match_scalar_mix);
+  RUN_TEST(test_blend4_matches_scalar_mix_in_every_byte);
+  RUN_TEST(test_blend1_matches_scalar_mix);
+  RUN_TEST(test_buffer_blend_and_ends);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// Settings log (src/settings.cpp) on the host EEPROM: pio test -e native-test
+#include <unity.h>
+#include <string.h>
+#include <EEPROM.h>
+#include "settings.h"
+
+// Erase the EEPROM, 'bytes' long, to 'fill' (0 on the host stand-in, 0xFF on a new chip)
+static void erase(uint16_t bytes, uint8_t fill) {
+  memset(EEPROM.data, fill, sizeof(EEPROM.data));
+  EEPROM.size = bytes;
+}
+
+// Load the settings at boot, as setup() does (all 0 if there are none)
+static void boot(SettingsRecord &rec) {
+  if(!settingsLoad(rec)) {
+    memset(&rec, 0, sizeof(rec));
+  }
+}
+
+static uint8_t *slotBytes(uint16_t slot) {
+  return EEPROM.data + slot * SETTINGS_RECORD_SIZE;
+}
+
+void setUp() {
+  erase(512, 0);
+}
+
+void tearDown() {}
+
+void test_empty_eeprom_has_no_settings() {
+  SettingsRecord rec;
+  TEST_ASSERT_FALSE(settingsLoad(rec));
+  erase(512, 0xFF);
+  TEST_ASSERT_FALSE(settingsLoad(rec));
+}
+
+void test_saved_settings_load_back() {
+  SettingsRecord rec = {};
+  settingsLoad(rec);
+  rec.pattern = 7;
+  rec.brightness = 64;
+  settingsSave(rec);
+
+  SettingsRecord loaded;
+  TEST_ASSERT_TRUE(settingsLoad(loaded));
+  TEST_ASSERT_EQUAL_UINT8(7, loaded.pattern);
+  TEST_ASSERT_EQUAL_UINT8(64, loaded.brightness);
+  TEST_ASSERT_EQUAL_UINT8(SETTINGS_MAGIC, loaded.magic);
+}
+
+// Many saves, each followed by a reboot: the newest record must win every time, through the slot
+// wraparound at the end of EEPROM and the sequence number wrapping past 255
+static void saveAndReboot(uint16_t bytes) {
+  erase(bytes, 0xFF);
+  uint16_t slots = bytes / SETTINGS_RECORD_SIZE;
+  for(uint16_t i = 0; i < slots * 5 + 3; i++) {
+    SettingsRecord rec;
+    boot(rec);
+    rec.pattern = i % 200 + 1;
+    rec.brightness = i;
+    settingsSave(rec);
+
+    SettingsRecord loaded;
+    TEST_ASSERT_TRUE(settingsLoad(loaded));
+    TEST_ASSERT_EQUAL_UINT8(i % 200 + 1, loaded.pattern);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)i, loaded.brightness);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)i, loaded.seq);
+    TEST_ASSERT_EQUAL_UINT8(SETTINGS_MAGIC, slotBytes(i % slots)[0]);   // written to the next slot in turn
+  }
+}
+
+void test_newest_record_wins_512() {
+  saveAndReboot(512);
+}
+
+void test_newest_record_wins_1024() {
+  saveAndReboot(1024);
+}
+
+void test_each_slot_written_once_per_lap() {
+  erase(512, 0);
+  SettingsRecord rec = {};
+  settingsLoad(rec);
+  unsigned long writes = EEPROM.writes;
+  for(uint16_t i = 0; i < 512 / SETTINGS_RECORD_SIZE; i++) {
+    rec.pattern = 1 + (i & 1);
+    settingsSave(rec);
+  }
+  TEST_ASSERT_TRUE(EEPROM.writes - writes <= 512);        // no cell written twice in one lap
+}
+
+void test_bad_crc_falls_back_to_previous_record() {
+  SettingsRecord rec = {};
+  settingsLoad(rec);
+  rec.pattern = 3;
+  settingsSave(rec);                                      // slot 0
+  rec.pattern = 4;
+  settingsSave(rec);                                      // slot 1
+  slotBytes(1)[2] ^= 0x10;                                // flip a bit of the pattern
+
+  SettingsRecord loaded;
+  TEST_ASSERT_TRUE(settingsLoad(loaded));
+  TEST_ASSERT_EQUAL_UINT8(3, loaded.pattern);
+  TEST_ASSERT_EQUAL_UINT8(0, loaded.seq);
+}
+
+void test_cut_short_save_keeps_previous_record() {
+  SettingsRecord rec = {};
+  settingsLoad(rec);
+  rec.pattern = 5;
+  settingsSave(rec);
+  SettingsRecord half = rec;                              // the next save, lost before its crc was written
+  half.seq++;
+  half.pattern = 6;
+  memcpy(slotBytes(1), &half, SETTINGS_RECORD_SIZE - 1);
+
+  SettingsRecord loaded;
+  TEST_ASSERT_TRUE(settingsLoad(loaded));
+  TEST_ASSERT_EQUAL_UINT8(5, loaded.pattern);
+}
+
+void test_save_after_bad_record_continues_the_log() {
+  SettingsRecord rec = {};
+  settingsLoad(rec);
+  for(uint8_t p = 1; p <= 3; p++) {
+    rec.pattern = p;
+    settingsSave(rec);                                    // slots 0-2, seq 0-2
+  }
+  slotBytes(2)[SETTINGS_RECORD_SIZE - 1] ^= 0xFF;         // newest record goes bad
+
+  boot(rec);                                              // slot 1 (seq 1) is the newest good one
+  TEST_ASSERT_EQUAL_UINT8(2, rec.pattern);
+  rec.pattern = 9;
+  settingsSave(rec);                                      // overwrites slot 2 with seq 2
+  SettingsRecord loaded;
+  TEST_ASSERT_TRUE(settingsLoad(loaded));
+  TEST_ASSERT_EQUAL_UINT8(9, loaded.pattern);
+  TEST_ASSERT_EQUAL_UINT8(2, loaded.seq);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_eeprom_has_no_settings);
+  RUN_TEST(test_saved_settings_load_back);
+  RUN_TEST(test_newest_record_wins_512);
+  RUN_TEST(test_newest_record_wins_1024);
+  RUN_TEST(test_each_slot_written_once_per_lap);
+  RUN_TEST(test_bad_crc_falls_back_to_previous_record);
+  RUN_TEST(test_cut_short_save_keeps_previous_record);
+  RUN_TEST(test_save_after_bad_record_continues_the_log);
+  return UNITY_END();
+}